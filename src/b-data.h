@@ -26,3 +26,5 @@
 #include <data/b-data-simple.h>
 #include <data/b-ring.h>
 #include <data/b-linear-range.h>
+#include <data/b-data-typed.h>
+#include <data/b-data-file.h>
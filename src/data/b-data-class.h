@@ -43,6 +43,77 @@ typedef struct {
   unsigned int columns;
 } BMatrixSize;
 
+/**
+ * BElementType:
+ * @B_ELEMENT_TYPE_DOUBLE: double precision floating point
+ * @B_ELEMENT_TYPE_FLOAT: single precision floating point
+ * @B_ELEMENT_TYPE_INT16: signed 16-bit integer
+ * @B_ELEMENT_TYPE_UINT16: unsigned 16-bit integer
+ * @B_ELEMENT_TYPE_UINT8: unsigned 8-bit integer
+ *
+ * The type of the elements in the native storage of a #BVector or #BMatrix.
+ */
+typedef enum {
+  B_ELEMENT_TYPE_DOUBLE,
+  B_ELEMENT_TYPE_FLOAT,
+  B_ELEMENT_TYPE_INT16,
+  B_ELEMENT_TYPE_UINT16,
+  B_ELEMENT_TYPE_UINT8
+} BElementType;
+
+/**
+ * BDataChangeType:
+ * @B_DATA_CHANGE_ALL: any part of the data, including its size, may have
+ *   changed
+ * @B_DATA_CHANGE_RANGE: only the elements from @start up to @end changed, and
+ *   the size did not change
+ * @B_DATA_CHANGE_APPEND: the elements from @start up to @end were appended,
+ *   and @n_dropped elements were removed from the beginning
+ *
+ * The kind of change described by a #BDataChange.
+ */
+typedef enum {
+  B_DATA_CHANGE_ALL,
+  B_DATA_CHANGE_RANGE,
+  B_DATA_CHANGE_APPEND
+} BDataChangeType;
+
+/**
+ * BSearchMode:
+ * @B_SEARCH_NEAREST: the element nearest to the value
+ * @B_SEARCH_LOWER: the element with the largest value not greater than the
+ *   value
+ * @B_SEARCH_UPPER: the element with the smallest value not less than the
+ *   value
+ *
+ * Which element b_vector_search() should return.
+ */
+typedef enum {
+  B_SEARCH_NEAREST,
+  B_SEARCH_LOWER,
+  B_SEARCH_UPPER
+} BSearchMode;
+
+/**
+ * BDataChange:
+ * @type: the kind of change
+ * @start: index of the first changed element, or row for matrices
+ * @end: index after the last changed element, or row for matrices
+ * @n_dropped: for %B_DATA_CHANGE_APPEND, the number of elements (rows for
+ *   matrices) removed from the beginning of the array
+ * @generation: the generation of the data after the change
+ *
+ * Describes what changed when a "changed" signal was emitted. Indices refer to
+ * the array after the change.
+ */
+typedef struct {
+  BDataChangeType type;
+  guint start;
+  guint end;
+  guint n_dropped;
+  guint64 generation;
+} BDataChange;
+
 /**
  * BDataClass:
  * @base: base class.
@@ -105,6 +176,10 @@ G_DECLARE_DERIVABLE_TYPE(BVector, b_vector, B, VECTOR, BData)
  * @load_values: loads the values and returns them.
  * @get_value: gets a value.
  * @replace_cache: replaces array cache
+ * @load_minmax: gets the minimum and maximum finite values, if the subclass
+ *   can do it faster than scanning the array. May be %NULL.
+ * @get_native: gets the values in their native storage type, if that is not
+ *   double. May be %NULL.
  *
  * Class for BVector.
  **/
@@ -116,6 +191,8 @@ struct _BVectorClass {
   double *(*load_values) (BVector * vec);
   double (*get_value) (BVector * vec, unsigned int i);
   double *(*replace_cache) (BVector *vec, unsigned int len);
+  void (*load_minmax) (BVector *vec, double *min, double *max);
+  gconstpointer (*get_native) (BVector *vec, BElementType *type);
 };
 
 G_DECLARE_DERIVABLE_TYPE(BMatrix, b_matrix, B, MATRIX, BData)
@@ -129,6 +206,10 @@ G_DECLARE_DERIVABLE_TYPE(BMatrix, b_matrix, B, MATRIX, BData)
  * @load_values: loads the values in the cache.
  * @get_value: gets a value.
  * @replace_cache: replaces array cache
+ * @load_minmax: gets the minimum and maximum finite values, if the subclass
+ *   can do it faster than scanning the array. May be %NULL.
+ * @get_native: gets the values in their native storage type, if that is not
+ *   double. May be %NULL.
  *
  * Class for BMatrix.
  **/
@@ -140,6 +221,8 @@ struct _BMatrixClass {
   double *(*load_values) (BMatrix * vec);
   double (*get_value) (BMatrix * mat, unsigned int i, unsigned int j);
   double *(*replace_cache) (BMatrix *mat, unsigned int len);
+  void (*load_minmax) (BMatrix *mat, double *min, double *max);
+  gconstpointer (*get_native) (BMatrix *mat, BElementType *type);
 };
 
 BData *b_data_dup(BData * src);
@@ -148,10 +231,18 @@ BData *b_data_dup_to_simple(BData * src);
 char *b_data_serialize(BData * dat, gpointer user);
 
 void b_data_emit_changed(BData * data);
+void b_data_emit_changed_range(BData * data, guint start, guint end);
+void b_data_emit_appended(BData * data, guint start, guint end, guint n_dropped);
+const BDataChange *b_data_get_change(BData * data);
+guint64 b_data_get_generation(BData * data);
+void b_data_begin_update(BData * data);
+void b_data_end_update(BData * data);
 gint64 b_data_get_timestamp(BData *data);
 
 gboolean b_data_has_value(BData * data);
 
+gsize b_element_type_get_size(BElementType type);
+
 char b_data_get_n_dimensions(BData * data);
 unsigned int b_data_get_n_values(BData * data);
 
@@ -168,6 +259,11 @@ double b_vector_get_value(BVector * vec, unsigned int i);
 char *b_vector_get_str(BVector * vec, unsigned int i, const gchar * format);
 gboolean b_vector_is_varying_uniformly(BVector * data);
 void b_vector_get_minmax(BVector * vec, double *min, double *max);
+gconstpointer b_vector_get_native_values(BVector * vec, BElementType *type);
+gboolean b_vector_get_range_minmax(BVector * vec, unsigned int start, unsigned int end, double *min, double *max);
+gboolean b_vector_is_sorted(BVector * vec);
+gboolean b_vector_find_range(BVector * vec, double a, double b, unsigned int *start, unsigned int *end);
+int b_vector_search(BVector * vec, double x, BSearchMode mode);
 
 /* to be used only by subclasses */
 double* b_vector_replace_cache(BVector *vec, unsigned int len);
@@ -182,6 +278,7 @@ double b_matrix_get_value(BMatrix * mat, unsigned int i, unsigned int j);
 char *b_matrix_get_str(BMatrix * mat, unsigned int i, unsigned int j,
 		       const gchar * format);
 void b_matrix_get_minmax(BMatrix * mat, double *min, double *max);
+gconstpointer b_matrix_get_native_values(BMatrix * mat, BElementType *type);
 
 /* to be used only by subclasses */
 double* b_matrix_replace_cache(BMatrix *mat, unsigned int len);
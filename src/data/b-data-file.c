@@ -0,0 +1,297 @@
+/*
+ * b-data-file.c :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "b-data-file.h"
+#include "b-data-private.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * SECTION: b-data-file
+ * @short_description: Data objects backed by files.
+ *
+ * b_data_new_from_npy() maps a NumPy .npy file into memory and returns a
+ * vector or matrix that uses the mapping as its array. Nothing is read or
+ * copied up front; the operating system pages in the parts of the file that
+ * are accessed, so opening a large recording is fast and only the displayed
+ * part needs to fit in memory.
+ *
+ * Raw binary files can be mapped with b_val_vector_new_mmap(),
+ * b_val_matrix_new_mmap(), b_typed_vector_new_mmap() and
+ * b_typed_matrix_new_mmap().
+ */
+
+/* Map @filename and find how many elements of size @element_size follow
+ * @offset. The data must be aligned to the element size. */
+GMappedFile *
+_b_mapped_file_new (const char *filename, goffset offset, gsize element_size,
+                    gsize * n_elements, GError ** error)
+{
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (element_size > 0, NULL);
+
+  if (offset < 0 || offset % element_size != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "Offset %" G_GINT64_FORMAT " in %s is not a multiple "
+                   "of the element size", (gint64) offset, filename);
+      return NULL;
+    }
+
+  GMappedFile *file = g_mapped_file_new (filename, FALSE, error);
+  if (file == NULL)
+    return NULL;
+
+  gsize len = g_mapped_file_get_length (file);
+  if ((gsize) offset > len)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "Offset %" G_GINT64_FORMAT " is past the end of %s",
+                   (gint64) offset, filename);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  gsize n = (len - offset) / element_size;
+  if (n > G_MAXUINT)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s has too many elements", filename);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+  *n_elements = n;
+  return file;
+}
+
+/* .npy format: magic string, version, header length, then a Python dict
+ * literal such as
+ * {'descr': '<f8', 'fortran_order': False, 'shape': (3, 4), }
+ * padded so that the data that follows is aligned */
+
+#define NPY_MAGIC "\x93NUMPY"
+#define NPY_MAGIC_LEN 6
+
+static gboolean
+npy_parse_descr (const char *descr, BElementType * type)
+{
+  static const struct
+  {
+    const char *code;
+    BElementType type;
+  } codes[] = {
+    {"f8", B_ELEMENT_TYPE_DOUBLE},
+    {"f4", B_ELEMENT_TYPE_FLOAT},
+    {"i2", B_ELEMENT_TYPE_INT16},
+    {"u2", B_ELEMENT_TYPE_UINT16},
+    {"u1", B_ELEMENT_TYPE_UINT8},
+  };
+  char order = descr[0];
+  gsize i;
+
+  if (strlen (descr) != 3)
+    return FALSE;
+  /* '|' means byte order doesn't apply, '=' is native */
+  if (order == '<' && G_BYTE_ORDER != G_LITTLE_ENDIAN)
+    return FALSE;
+  if (order == '>' && G_BYTE_ORDER != G_BIG_ENDIAN)
+    return FALSE;
+  if (order != '<' && order != '>' && order != '|' && order != '=')
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (codes); i++)
+    {
+      if (strcmp (descr + 1, codes[i].code) == 0)
+        {
+          *type = codes[i].type;
+          return TRUE;
+        }
+    }
+  return FALSE;
+}
+
+/* find the value following 'key': in the header dict */
+static const char *
+npy_find_key (const char *header, const char *key)
+{
+  g_autofree char *quoted = g_strdup_printf ("'%s'", key);
+  const char *p = strstr (header, quoted);
+  if (p == NULL)
+    return NULL;
+  p = strchr (p + strlen (quoted), ':');
+  if (p == NULL)
+    return NULL;
+  p++;
+  while (*p == ' ')
+    p++;
+  return p;
+}
+
+static gboolean
+npy_parse_header (const char *header, BElementType * type,
+                  guint64 * shape, int *ndim)
+{
+  const char *p = npy_find_key (header, "descr");
+  if (p == NULL || *p != '\'')
+    return FALSE;
+  const char *end = strchr (p + 1, '\'');
+  if (end == NULL)
+    return FALSE;
+  g_autofree char *descr = g_strndup (p + 1, end - p - 1);
+  if (!npy_parse_descr (descr, type))
+    return FALSE;
+
+  p = npy_find_key (header, "fortran_order");
+  if (p == NULL || strncmp (p, "False", 5) != 0)
+    return FALSE;
+
+  p = npy_find_key (header, "shape");
+  if (p == NULL || *p != '(')
+    return FALSE;
+  p++;
+  *ndim = 0;
+  while (TRUE)
+    {
+      char *next;
+      while (*p == ' ' || *p == ',')
+        p++;
+      if (*p == ')')
+        break;
+      if (*ndim == 3 || !g_ascii_isdigit (*p))
+        return FALSE;
+      shape[(*ndim)++] = g_ascii_strtoull (p, &next, 10);
+      p = next;
+    }
+  return TRUE;
+}
+
+/**
+ * b_data_new_from_npy:
+ * @filename: path of a .npy file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Create a vector or matrix from a NumPy .npy file by mapping it into memory,
+ * without copying. One-dimensional arrays become vectors and two-dimensional
+ * arrays become matrices. For arrays with three dimensions, such as a stack
+ * of images, the first two dimensions are combined into the rows of the
+ * matrix.
+ *
+ * Arrays of doubles become a #BValVector or #BValMatrix. Arrays of float32,
+ * int16, uint16 and uint8 become a #BTypedVector or #BTypedMatrix. The array
+ * must be in C order and in the machine's byte order. The data is read-only.
+ *
+ * Returns: (transfer full) (nullable): a #BData, or %NULL with @error set if
+ *   the file could not be read.
+ **/
+BData *
+b_data_new_from_npy (const char *filename, GError ** error)
+{
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  GMappedFile *file = g_mapped_file_new (filename, FALSE, error);
+  if (file == NULL)
+    return NULL;
+
+  const guchar *c = (const guchar *) g_mapped_file_get_contents (file);
+  gsize len = g_mapped_file_get_length (file);
+  gsize header_start, header_len = 0;
+
+  if (len >= NPY_MAGIC_LEN + 4 && memcmp (c, NPY_MAGIC, NPY_MAGIC_LEN) == 0)
+    {
+      if (c[6] == 1)
+        {
+          header_start = 10;
+          header_len = c[8] | (c[9] << 8);
+        }
+      else
+        {
+          header_start = 12;
+          if (len >= header_start)
+            header_len = c[8] | (c[9] << 8) | (c[10] << 16)
+              | ((gsize) c[11] << 24);
+        }
+    }
+  else
+    header_start = len + 1;
+
+  if (header_start + header_len > len || header_len == 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s is not a .npy file", filename);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  g_autofree char *header = g_strndup ((const char *) c + header_start,
+                                       header_len);
+  BElementType type;
+  guint64 shape[3];
+  int ndim;
+
+  if (!npy_parse_header (header, &type, shape, &ndim) || ndim == 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "Unsupported array in %s: %s", filename, header);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  gsize offset = header_start + header_len;
+  gsize elsize = b_element_type_get_size (type);
+  guint64 rows = shape[0], columns = 1, n;
+  gboolean too_many = FALSE;
+  if (ndim == 2)
+    columns = shape[1];
+  else if (ndim == 3)
+    {
+      too_many = !g_uint64_checked_mul (&rows, shape[0], shape[1]);
+      columns = shape[2];
+    }
+
+  /* sizes and indices are unsigned int */
+  too_many = too_many || !g_uint64_checked_mul (&n, rows, columns);
+  if (too_many || n > G_MAXUINT)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s has too many elements", filename);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  if (columns > 0 && rows > (len - offset) / elsize / columns)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s is shorter than its header says", filename);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  if (ndim == 1)
+    {
+      if (type == B_ELEMENT_TYPE_DOUBLE)
+        return _b_val_vector_new_mapped (file, offset, rows);
+      return _b_typed_vector_new_mapped (file, offset, type, rows);
+    }
+  if (type == B_ELEMENT_TYPE_DOUBLE)
+    return _b_val_matrix_new_mapped (file, offset, rows, columns);
+  return _b_typed_matrix_new_mapped (file, offset, type, rows, columns);
+}
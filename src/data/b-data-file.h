@@ -0,0 +1,31 @@
+/*
+ * b-data-file.h :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#pragma once
+
+#include "data/b-data-class.h"
+
+G_BEGIN_DECLS
+
+BData *b_data_new_from_npy (const char *filename, GError **error);
+
+G_END_DECLS
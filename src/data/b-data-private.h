@@ -0,0 +1,63 @@
+/*
+ * b-data-private.h :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#pragma once
+
+/* Not installed: helpers shared between the data classes. */
+
+#include <glib.h>
+#include "b-data-class.h"
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL
+gboolean _b_minmax_double (const double *v, gsize n, double *min, double *max);
+
+G_GNUC_INTERNAL
+gboolean _b_minmax_typed (gconstpointer v, BElementType type, gsize n,
+                          double *min, double *max);
+
+G_GNUC_INTERNAL
+double _b_element_get (gconstpointer data, BElementType type, gsize i);
+
+G_GNUC_INTERNAL
+void _b_element_convert (gconstpointer in, BElementType type, double *out,
+                         gsize n);
+
+G_GNUC_INTERNAL
+GMappedFile *_b_mapped_file_new (const char *filename, goffset offset,
+                                 gsize element_size, gsize *n_elements,
+                                 GError **error);
+
+G_GNUC_INTERNAL
+BData *_b_val_vector_new_mapped (GMappedFile *file, gsize offset, guint n);
+G_GNUC_INTERNAL
+BData *_b_val_matrix_new_mapped (GMappedFile *file, gsize offset,
+                                 guint rows, guint columns);
+G_GNUC_INTERNAL
+BData *_b_typed_vector_new_mapped (GMappedFile *file, gsize offset,
+                                   BElementType type, guint n);
+G_GNUC_INTERNAL
+BData *_b_typed_matrix_new_mapped (GMappedFile *file, gsize offset,
+                                   BElementType type, guint rows,
+                                   guint columns);
+
+G_END_DECLS
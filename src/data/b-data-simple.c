@@ -21,6 +21,7 @@
  */
 
 #include "b-data-simple.h"
+#include "b-data-private.h"
 #include <math.h>
 
 #include <string.h>
@@ -42,6 +43,11 @@
  * The get_values() methods can be used to get a const version of the array. To
  * get a modifiable version, use the get_array() methods for #BValVector and
  * #BValMatrix.
+ *
+ * b_val_vector_new_mmap() and b_val_matrix_new_mmap() map a binary file into
+ * memory and use the mapping as the array, without reading or copying it.
+ * Pages are only read from disk when they are accessed, so large recordings
+ * can be opened instantly. The mapping is read-only.
  */
 
 /*****************************************************************************/
@@ -58,6 +64,7 @@ struct _BValVector
   guint n;
   double *val;
   GDestroyNotify notify;
+  GMappedFile *file;
 };
 
 G_DEFINE_TYPE (BValVector, b_val_vector, B_TYPE_VECTOR);
@@ -68,6 +75,7 @@ b_val_vector_finalize (GObject * obj)
   BValVector *vec = (BValVector *) obj;
   if (vec->notify && vec->val)
     (*vec->notify) (vec->val);
+  g_clear_pointer (&vec->file, g_mapped_file_unref);
 
   GObjectClass *obj_class = G_OBJECT_CLASS (b_val_vector_parent_class);
 
@@ -87,6 +95,8 @@ b_val_vector_dup (BData * src)
     }
   else
     dst->val = src_val->val;
+  if (src_val->file)
+    dst->file = g_mapped_file_ref (src_val->file);
   dst->n = src_val->n;
   return B_DATA (dst);
 }
@@ -202,6 +212,41 @@ b_val_vector_new_copy (const double *val, guint n)
   return b_val_vector_new (val2, n, g_free);
 }
 
+/**
+ * b_val_vector_new_mmap:
+ * @filename: path of a file of native-endian doubles
+ * @offset: number of bytes to skip at the start of the file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Create a new #BValVector from the contents of a raw binary file, by mapping
+ * it into memory. The length of the vector is the number of doubles in the
+ * file after @offset. The array is read-only.
+ *
+ * Returns: (nullable): a #BData, or %NULL if the file could not be mapped
+ **/
+BData *
+b_val_vector_new_mmap (const char *filename, goffset offset, GError ** error)
+{
+  gsize n;
+  GMappedFile *file =
+    _b_mapped_file_new (filename, offset, sizeof (double), &n, error);
+  if (file == NULL)
+    return NULL;
+  return _b_val_vector_new_mapped (file, offset, n);
+}
+
+/* Takes the reference to @file. */
+BData *
+_b_val_vector_new_mapped (GMappedFile * file, gsize offset, guint n)
+{
+  BValVector *res = g_object_new (B_TYPE_VAL_VECTOR, NULL);
+  if (n > 0)
+    res->val = (double *) (g_mapped_file_get_contents (file) + offset);
+  res->n = n;
+  res->file = file;
+  return B_DATA (res);
+}
+
 /**
  * b_val_vector_replace_array :
  * @s: #BValVector
@@ -209,26 +254,33 @@ b_val_vector_new_copy (const double *val, guint n)
  * @n: length of array
  * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
  *
- * Replace the array of values of @s.
+ * Replace the array of values of @s. If the length is unchanged, the change is
+ * reported as a %B_DATA_CHANGE_RANGE covering the whole vector.
  **/
 void
 b_val_vector_replace_array (BValVector * s, double *array, guint n,
 			    GDestroyNotify notify)
 {
   g_return_if_fail (B_IS_VAL_VECTOR (s));
+  guint old_n = s->n;
   if (s->val && s->notify)
     (*s->notify) (s->val);
+  g_clear_pointer (&s->file, g_mapped_file_unref);
   s->val = array;
   s->n = n;
   s->notify = notify;
-  b_data_emit_changed (B_DATA (s));
+  if (n == old_n)
+    b_data_emit_changed_range (B_DATA (s), 0, n);
+  else
+    b_data_emit_changed (B_DATA (s));
 }
 
 /**
  * b_val_vector_get_array :
  * @s: #BValVector
  *
- * Get the array of values of @vec.
+ * Get the array of values of @vec. If @s was created with
+ * b_val_vector_new_mmap(), the array is read-only.
  *
  * Returns: an array. Should not be freed.
  **/
@@ -253,6 +305,7 @@ struct _BValMatrix
   BMatrixSize size;
   double *val;
   GDestroyNotify notify;
+  GMappedFile *file;
 };
 
 G_DEFINE_TYPE (BValMatrix, b_val_matrix, B_TYPE_MATRIX);
@@ -263,6 +316,7 @@ b_val_matrix_finalize (GObject * obj)
   BValMatrix *mat = (BValMatrix *) obj;
   if (mat->notify && mat->val)
     (*mat->notify) (mat->val);
+  g_clear_pointer (&mat->file, g_mapped_file_unref);
 
   G_OBJECT_CLASS (b_val_matrix_parent_class)->finalize (obj);
 }
@@ -281,6 +335,8 @@ b_val_matrix_dup (BData * src)
     }
   else
     dst->val = src_val->val;
+  if (src_val->file)
+    dst->file = g_mapped_file_ref (src_val->file);
   dst->size = src_val->size;
   return B_DATA (dst);
 }
@@ -399,11 +455,52 @@ b_val_matrix_new_alloc (guint rows, guint columns)
   return B_DATA (res);
 }
 
+/**
+ * b_val_matrix_new_mmap:
+ * @filename: path of a file of native-endian doubles, in row-major order
+ * @offset: number of bytes to skip at the start of the file
+ * @columns: number of columns
+ * @error: return location for a #GError, or %NULL
+ *
+ * Create a new #BValMatrix from the contents of a raw binary file, by mapping
+ * it into memory. The number of rows is the number of complete rows in the
+ * file after @offset. The array is read-only.
+ *
+ * Returns: (nullable): a #BData, or %NULL if the file could not be mapped
+ **/
+BData *
+b_val_matrix_new_mmap (const char *filename, goffset offset, guint columns,
+		       GError ** error)
+{
+  gsize n;
+  g_return_val_if_fail (columns > 0, NULL);
+  GMappedFile *file =
+    _b_mapped_file_new (filename, offset, sizeof (double), &n, error);
+  if (file == NULL)
+    return NULL;
+  return _b_val_matrix_new_mapped (file, offset, n / columns, columns);
+}
+
+/* Takes the reference to @file. */
+BData *
+_b_val_matrix_new_mapped (GMappedFile * file, gsize offset, guint rows,
+			  guint columns)
+{
+  BValMatrix *res = g_object_new (B_TYPE_VAL_MATRIX, NULL);
+  if (rows > 0 && columns > 0)
+    res->val = (double *) (g_mapped_file_get_contents (file) + offset);
+  res->size.rows = rows;
+  res->size.columns = columns;
+  res->file = file;
+  return B_DATA (res);
+}
+
 /**
  * b_val_matrix_get_array :
  * @s: #BValVector
  *
- * Get the array of values of @s.
+ * Get the array of values of @s. If @s was created with
+ * b_val_matrix_new_mmap(), the array is read-only.
  *
  * Returns: an array. Should not be freed.
  **/
@@ -423,21 +520,26 @@ b_val_matrix_get_array (BValMatrix * s)
  * @columns: number of columns
  * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
  *
- * Get the array of values of @s.
- *
+ * Replace the array of values of @s. If the size is unchanged, the change is
+ * reported as a %B_DATA_CHANGE_RANGE covering all rows.
  **/
 void
 b_val_matrix_replace_array (BValMatrix * s, double *array, guint rows,
 			    guint columns, GDestroyNotify notify)
 {
   g_return_if_fail (B_IS_VAL_MATRIX (s));
+  BMatrixSize old_size = s->size;
   if (s->val && s->notify)
     (*s->notify) (s->val);
+  g_clear_pointer (&s->file, g_mapped_file_unref);
   s->val = array;
   s->size.rows = rows;
   s->size.columns = columns;
   s->notify = notify;
-  b_data_emit_changed (B_DATA (s));
+  if (rows == old_size.rows && columns == old_size.columns)
+    b_data_emit_changed_range (B_DATA (s), 0, rows);
+  else
+    b_data_emit_changed (B_DATA (s));
 }
 
 /********************************************/
@@ -33,6 +33,7 @@ G_DECLARE_FINAL_TYPE(BValVector,b_val_vector,B,VAL_VECTOR,BVector)
 BData	*b_val_vector_new      (double *val, guint n, GDestroyNotify   notify);
 BData	*b_val_vector_new_alloc (guint n);
 BData	*b_val_vector_new_copy (const double *val, guint n);
+BData *b_val_vector_new_mmap (const char *filename, goffset offset, GError **error);
 
 double *b_val_vector_get_array (BValVector *s);
 void b_val_vector_replace_array(BValVector *s, double *array, guint n, GDestroyNotify notify);
@@ -45,6 +46,7 @@ BData	*b_val_matrix_new      (double *val, guint rows, guint columns, GDestroyNo
 BData *b_val_matrix_new_copy (const double   *val,
                                      guint  rows, guint columns);
 BData *b_val_matrix_new_alloc (guint rows, guint columns);
+BData *b_val_matrix_new_mmap (const char *filename, goffset offset, guint columns, GError **error);
 
 double *b_val_matrix_get_array (BValMatrix *s);
 void b_val_matrix_replace_array(BValMatrix *s, double *array, guint rows, guint columns, GDestroyNotify notify);
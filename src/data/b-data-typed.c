@@ -0,0 +1,612 @@
+/*
+ * b-data-typed.c :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "b-data-typed.h"
+#include "b-data-private.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION: b-data-typed
+ * @short_description: Data objects that keep their native element type.
+ *
+ * Data classes #BTypedVector and #BTypedMatrix hold arrays of single precision
+ * floating point numbers or 8 or 16-bit integers, as produced by cameras and
+ * digitizers, without converting them to double precision. A #BTypedMatrix of
+ * 16-bit integers takes a quarter of the memory of the equivalent #BValMatrix.
+ *
+ * Consumers that understand the native types, such as #BDensityView and
+ * #BScatterLineView, read the array through b_vector_get_native_values() and
+ * b_matrix_get_native_values(). The minimum and maximum are also found
+ * without conversion. A double precision copy is only made when
+ * b_vector_get_values() or b_matrix_get_values() is called.
+ *
+ * Like their double precision counterparts, typed vectors and matrices can be
+ * created from a memory-mapped raw file with b_typed_vector_new_mmap() and
+ * b_typed_matrix_new_mmap().
+ */
+
+/*****************************************************************************/
+
+/**
+ * BTypedVector:
+ *
+ * Object holding a one-dimensional array of numbers of a #BElementType.
+ **/
+
+struct _BTypedVector
+{
+  BVector base;
+  guint n;
+  BElementType type;
+  gpointer data;
+  GDestroyNotify notify;
+  GMappedFile *file;
+  double *cache;                /* double copy, only for get_values() */
+  guint cache_len;
+};
+
+G_DEFINE_TYPE (BTypedVector, b_typed_vector, B_TYPE_VECTOR);
+
+static void
+b_typed_vector_finalize (GObject * obj)
+{
+  BTypedVector *vec = (BTypedVector *) obj;
+  if (vec->notify && vec->data)
+    (*vec->notify) (vec->data);
+  g_clear_pointer (&vec->file, g_mapped_file_unref);
+  g_free (vec->cache);
+
+  G_OBJECT_CLASS (b_typed_vector_parent_class)->finalize (obj);
+}
+
+static BData *
+b_typed_vector_dup (BData * src)
+{
+  BTypedVector const *s = (BTypedVector const *) src;
+  if (s->file)
+    return _b_typed_vector_new_mapped (g_mapped_file_ref (s->file),
+                                       (const gchar *) s->data -
+                                       g_mapped_file_get_contents (s->file),
+                                       s->type, s->n);
+  return b_typed_vector_new_copy (s->data, s->type, s->n);
+}
+
+static guint
+b_typed_vector_load_len (BVector * vec)
+{
+  return ((BTypedVector *) vec)->n;
+}
+
+static double *
+b_typed_vector_ensure_cache (BTypedVector * vec, guint len)
+{
+  if (vec->cache == NULL || vec->cache_len != len)
+    {
+      g_free (vec->cache);
+      vec->cache = g_new0 (double, MAX (len, 1));
+      vec->cache_len = len;
+    }
+  return vec->cache;
+}
+
+static double *
+b_typed_vector_load_values (BVector * vec)
+{
+  BTypedVector *val = (BTypedVector *) vec;
+  double *cache = b_typed_vector_ensure_cache (val, val->n);
+
+  if (val->data)
+    _b_element_convert (val->data, val->type, cache, val->n);
+  return cache;
+}
+
+static double
+b_typed_vector_get_value (BVector * vec, guint i)
+{
+  BTypedVector const *val = (BTypedVector const *) vec;
+  g_return_val_if_fail (val->data != NULL && i < val->n, NAN);
+  return _b_element_get (val->data, val->type, i);
+}
+
+static double *
+b_typed_vector_replace_cache (BVector * vec, guint len)
+{
+  BTypedVector *val = (BTypedVector *) vec;
+
+  if (len != val->n)
+    {
+      g_warning ("Trying to replace cache in BTypedVector.");
+    }
+  return b_typed_vector_ensure_cache (val, len);
+}
+
+static void
+b_typed_vector_load_minmax (BVector * vec, double *min, double *max)
+{
+  BTypedVector const *val = (BTypedVector const *) vec;
+  _b_minmax_typed (val->data, val->type, val->data ? val->n : 0, min, max);
+}
+
+static gconstpointer
+b_typed_vector_get_native (BVector * vec, BElementType * type)
+{
+  BTypedVector const *val = (BTypedVector const *) vec;
+  *type = val->type;
+  return val->data;
+}
+
+static void
+b_typed_vector_class_init (BTypedVectorClass * klass)
+{
+  GObjectClass *gobject_klass = (GObjectClass *) klass;
+  BDataClass *data_klass = (BDataClass *) klass;
+  BVectorClass *vector_klass = (BVectorClass *) klass;
+
+  gobject_klass->finalize = b_typed_vector_finalize;
+  data_klass->dup = b_typed_vector_dup;
+  vector_klass->load_len = b_typed_vector_load_len;
+  vector_klass->load_values = b_typed_vector_load_values;
+  vector_klass->get_value = b_typed_vector_get_value;
+  vector_klass->replace_cache = b_typed_vector_replace_cache;
+  vector_klass->load_minmax = b_typed_vector_load_minmax;
+  vector_klass->get_native = b_typed_vector_get_native;
+}
+
+static void
+b_typed_vector_init (BTypedVector * val)
+{
+}
+
+/**
+ * b_typed_vector_new: (skip)
+ * @data: array of @n elements of type @type
+ * @type: the element type
+ * @n: length of array
+ * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
+ *
+ * Create a new #BTypedVector from an existing array.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_vector_new (gpointer data, BElementType type, guint n,
+                    GDestroyNotify notify)
+{
+  BTypedVector *res = g_object_new (B_TYPE_TYPED_VECTOR, NULL);
+  res->data = data;
+  res->type = type;
+  res->n = n;
+  res->notify = notify;
+  return B_DATA (res);
+}
+
+/**
+ * b_typed_vector_new_alloc:
+ * @type: the element type
+ * @n: length of array
+ *
+ * Create a new #BTypedVector of length @n, initialized to zeros.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_vector_new_alloc (BElementType type, guint n)
+{
+  gpointer data = g_malloc0 (b_element_type_get_size (type) * n);
+  return b_typed_vector_new (data, type, n, g_free);
+}
+
+/**
+ * b_typed_vector_new_copy: (skip)
+ * @data: array of @n elements of type @type
+ * @type: the element type
+ * @n: length of array
+ *
+ * Create a new #BTypedVector, copying from an existing array.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_vector_new_copy (gconstpointer data, BElementType type, guint n)
+{
+  g_return_val_if_fail (data != NULL || n == 0, NULL);
+  gpointer d = g_memdup2 (data, b_element_type_get_size (type) * n);
+  return b_typed_vector_new (d, type, n, g_free);
+}
+
+/**
+ * b_typed_vector_new_mmap:
+ * @filename: path of a file of native-endian elements of type @type
+ * @offset: number of bytes to skip at the start of the file
+ * @type: the element type
+ * @error: return location for a #GError, or %NULL
+ *
+ * Create a new #BTypedVector from the contents of a raw binary file, by
+ * mapping it into memory. The length of the vector is the number of elements
+ * in the file after @offset. The array is read-only.
+ *
+ * Returns: (nullable): a #BData, or %NULL if the file could not be mapped
+ **/
+BData *
+b_typed_vector_new_mmap (const char *filename, goffset offset,
+                         BElementType type, GError ** error)
+{
+  gsize n;
+  GMappedFile *file = _b_mapped_file_new (filename, offset,
+                                          b_element_type_get_size (type),
+                                          &n, error);
+  if (file == NULL)
+    return NULL;
+  return _b_typed_vector_new_mapped (file, offset, type, n);
+}
+
+/* Takes the reference to @file. */
+BData *
+_b_typed_vector_new_mapped (GMappedFile * file, gsize offset,
+                            BElementType type, guint n)
+{
+  gpointer data = n > 0 ? g_mapped_file_get_contents (file) + offset : NULL;
+  BTypedVector *res = (BTypedVector *) b_typed_vector_new (data, type, n,
+                                                           NULL);
+  res->file = file;
+  return B_DATA (res);
+}
+
+/**
+ * b_typed_vector_get_data : (skip)
+ * @s: #BTypedVector
+ * @type: (out) (optional): return location for the element type
+ *
+ * Get the array of values of @s. After modifying it, call
+ * b_data_emit_changed(). If @s was created with b_typed_vector_new_mmap(),
+ * the array is read-only.
+ *
+ * Returns: an array. Should not be freed.
+ **/
+gpointer
+b_typed_vector_get_data (BTypedVector * s, BElementType * type)
+{
+  g_return_val_if_fail (B_IS_TYPED_VECTOR (s), NULL);
+  if (type)
+    *type = s->type;
+  return s->data;
+}
+
+/**
+ * b_typed_vector_replace_data : (skip)
+ * @s: #BTypedVector
+ * @data: array of @n elements of type @type
+ * @type: the element type
+ * @n: length of array
+ * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
+ *
+ * Replace the array of values of @s.
+ **/
+void
+b_typed_vector_replace_data (BTypedVector * s, gpointer data,
+                             BElementType type, guint n,
+                             GDestroyNotify notify)
+{
+  g_return_if_fail (B_IS_TYPED_VECTOR (s));
+  if (s->data && s->notify)
+    (*s->notify) (s->data);
+  g_clear_pointer (&s->file, g_mapped_file_unref);
+  s->data = data;
+  s->type = type;
+  s->n = n;
+  s->notify = notify;
+  b_data_emit_changed (B_DATA (s));
+}
+
+/*****************************************************************************/
+
+/**
+ * BTypedMatrix:
+ *
+ * Object holding a two-dimensional array of numbers of a #BElementType.
+ **/
+
+struct _BTypedMatrix
+{
+  BMatrix base;
+  BMatrixSize size;
+  BElementType type;
+  gpointer data;
+  GDestroyNotify notify;
+  GMappedFile *file;
+  double *cache;                /* double copy, only for get_values() */
+  guint cache_len;
+};
+
+G_DEFINE_TYPE (BTypedMatrix, b_typed_matrix, B_TYPE_MATRIX);
+
+static void
+b_typed_matrix_finalize (GObject * obj)
+{
+  BTypedMatrix *mat = (BTypedMatrix *) obj;
+  if (mat->notify && mat->data)
+    (*mat->notify) (mat->data);
+  g_clear_pointer (&mat->file, g_mapped_file_unref);
+  g_free (mat->cache);
+
+  G_OBJECT_CLASS (b_typed_matrix_parent_class)->finalize (obj);
+}
+
+static BData *
+b_typed_matrix_dup (BData * src)
+{
+  BTypedMatrix const *s = (BTypedMatrix const *) src;
+  if (s->file)
+    return _b_typed_matrix_new_mapped (g_mapped_file_ref (s->file),
+                                       (const gchar *) s->data -
+                                       g_mapped_file_get_contents (s->file),
+                                       s->type, s->size.rows,
+                                       s->size.columns);
+  return b_typed_matrix_new_copy (s->data, s->type, s->size.rows,
+                                  s->size.columns);
+}
+
+static BMatrixSize
+b_typed_matrix_load_size (BMatrix * mat)
+{
+  return ((BTypedMatrix *) mat)->size;
+}
+
+static double *
+b_typed_matrix_ensure_cache (BTypedMatrix * mat, guint len)
+{
+  if (mat->cache == NULL || mat->cache_len != len)
+    {
+      g_free (mat->cache);
+      mat->cache = g_new0 (double, MAX (len, 1));
+      mat->cache_len = len;
+    }
+  return mat->cache;
+}
+
+static double *
+b_typed_matrix_load_values (BMatrix * mat)
+{
+  BTypedMatrix *val = (BTypedMatrix *) mat;
+  guint len = val->size.rows * val->size.columns;
+  double *cache = b_typed_matrix_ensure_cache (val, len);
+
+  if (val->data)
+    _b_element_convert (val->data, val->type, cache, len);
+  return cache;
+}
+
+static double
+b_typed_matrix_get_value (BMatrix * mat, guint i, guint j)
+{
+  BTypedMatrix const *val = (BTypedMatrix const *) mat;
+  g_return_val_if_fail (val->data != NULL && i < val->size.rows
+                        && j < val->size.columns, NAN);
+  return _b_element_get (val->data, val->type, i * val->size.columns + j);
+}
+
+static double *
+b_typed_matrix_replace_cache (BMatrix * mat, guint len)
+{
+  BTypedMatrix *val = (BTypedMatrix *) mat;
+
+  if (len != val->size.rows * val->size.columns)
+    {
+      g_warning ("Trying to replace cache in BTypedMatrix.");
+    }
+  return b_typed_matrix_ensure_cache (val, len);
+}
+
+static void
+b_typed_matrix_load_minmax (BMatrix * mat, double *min, double *max)
+{
+  BTypedMatrix const *val = (BTypedMatrix const *) mat;
+  gsize len = val->data ? (gsize) val->size.rows * val->size.columns : 0;
+  _b_minmax_typed (val->data, val->type, len, min, max);
+}
+
+static gconstpointer
+b_typed_matrix_get_native (BMatrix * mat, BElementType * type)
+{
+  BTypedMatrix const *val = (BTypedMatrix const *) mat;
+  *type = val->type;
+  return val->data;
+}
+
+static void
+b_typed_matrix_class_init (BTypedMatrixClass * klass)
+{
+  GObjectClass *gobject_klass = (GObjectClass *) klass;
+  BDataClass *data_klass = (BDataClass *) klass;
+  BMatrixClass *matrix_klass = (BMatrixClass *) klass;
+
+  gobject_klass->finalize = b_typed_matrix_finalize;
+  data_klass->dup = b_typed_matrix_dup;
+  matrix_klass->load_size = b_typed_matrix_load_size;
+  matrix_klass->load_values = b_typed_matrix_load_values;
+  matrix_klass->get_value = b_typed_matrix_get_value;
+  matrix_klass->replace_cache = b_typed_matrix_replace_cache;
+  matrix_klass->load_minmax = b_typed_matrix_load_minmax;
+  matrix_klass->get_native = b_typed_matrix_get_native;
+}
+
+static void
+b_typed_matrix_init (BTypedMatrix * val)
+{
+}
+
+/**
+ * b_typed_matrix_new: (skip)
+ * @data: array of @rows*@columns elements of type @type, in row-major order
+ * @type: the element type
+ * @rows: number of rows
+ * @columns: number of columns
+ * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
+ *
+ * Create a new #BTypedMatrix using an existing array.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_matrix_new (gpointer data, BElementType type, guint rows,
+                    guint columns, GDestroyNotify notify)
+{
+  BTypedMatrix *res = g_object_new (B_TYPE_TYPED_MATRIX, NULL);
+  res->data = data;
+  res->type = type;
+  res->size.rows = rows;
+  res->size.columns = columns;
+  res->notify = notify;
+  return B_DATA (res);
+}
+
+/**
+ * b_typed_matrix_new_alloc:
+ * @type: the element type
+ * @rows: number of rows
+ * @columns: number of columns
+ *
+ * Allocate a new array with @rows rows and @columns columns and use it in a
+ * new #BTypedMatrix.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_matrix_new_alloc (BElementType type, guint rows, guint columns)
+{
+  gpointer data =
+    g_malloc0 (b_element_type_get_size (type) * rows * columns);
+  return b_typed_matrix_new (data, type, rows, columns, g_free);
+}
+
+/**
+ * b_typed_matrix_new_copy: (skip)
+ * @data: array of @rows*@columns elements of type @type
+ * @type: the element type
+ * @rows: number of rows
+ * @columns: number of columns
+ *
+ * Create a new #BTypedMatrix, copying from an existing array.
+ *
+ * Returns: a #BData
+ **/
+BData *
+b_typed_matrix_new_copy (gconstpointer data, BElementType type, guint rows,
+                         guint columns)
+{
+  gsize size = b_element_type_get_size (type) * rows * columns;
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+  return b_typed_matrix_new (g_memdup2 (data, size), type, rows, columns,
+                             g_free);
+}
+
+/**
+ * b_typed_matrix_new_mmap:
+ * @filename: path of a file of native-endian elements of type @type, in
+ *   row-major order
+ * @offset: number of bytes to skip at the start of the file
+ * @type: the element type
+ * @columns: number of columns
+ * @error: return location for a #GError, or %NULL
+ *
+ * Create a new #BTypedMatrix from the contents of a raw binary file, by
+ * mapping it into memory. The number of rows is the number of complete rows
+ * in the file after @offset. The array is read-only.
+ *
+ * Returns: (nullable): a #BData, or %NULL if the file could not be mapped
+ **/
+BData *
+b_typed_matrix_new_mmap (const char *filename, goffset offset,
+                         BElementType type, guint columns, GError ** error)
+{
+  gsize n;
+  g_return_val_if_fail (columns > 0, NULL);
+  GMappedFile *file = _b_mapped_file_new (filename, offset,
+                                          b_element_type_get_size (type),
+                                          &n, error);
+  if (file == NULL)
+    return NULL;
+  return _b_typed_matrix_new_mapped (file, offset, type, n / columns,
+                                     columns);
+}
+
+/* Takes the reference to @file. */
+BData *
+_b_typed_matrix_new_mapped (GMappedFile * file, gsize offset,
+                            BElementType type, guint rows, guint columns)
+{
+  gpointer data = (rows > 0 && columns > 0)
+    ? g_mapped_file_get_contents (file) + offset : NULL;
+  BTypedMatrix *res = (BTypedMatrix *) b_typed_matrix_new (data, type, rows,
+                                                           columns, NULL);
+  res->file = file;
+  return B_DATA (res);
+}
+
+/**
+ * b_typed_matrix_get_data : (skip)
+ * @s: #BTypedMatrix
+ * @type: (out) (optional): return location for the element type
+ *
+ * Get the array of values of @s. After modifying it, call
+ * b_data_emit_changed(). If @s was created with b_typed_matrix_new_mmap(),
+ * the array is read-only.
+ *
+ * Returns: an array. Should not be freed.
+ **/
+gpointer
+b_typed_matrix_get_data (BTypedMatrix * s, BElementType * type)
+{
+  g_return_val_if_fail (B_IS_TYPED_MATRIX (s), NULL);
+  if (type)
+    *type = s->type;
+  return s->data;
+}
+
+/**
+ * b_typed_matrix_replace_data : (skip)
+ * @s: #BTypedMatrix
+ * @data: array of @rows*@columns elements of type @type
+ * @type: the element type
+ * @rows: number of rows
+ * @columns: number of columns
+ * @notify: (nullable): the function to be called to free the array when the #BData is unreferenced, or %NULL
+ *
+ * Replace the array of values of @s.
+ **/
+void
+b_typed_matrix_replace_data (BTypedMatrix * s, gpointer data,
+                             BElementType type, guint rows, guint columns,
+                             GDestroyNotify notify)
+{
+  g_return_if_fail (B_IS_TYPED_MATRIX (s));
+  if (s->data && s->notify)
+    (*s->notify) (s->data);
+  g_clear_pointer (&s->file, g_mapped_file_unref);
+  s->data = data;
+  s->type = type;
+  s->size.rows = rows;
+  s->size.columns = columns;
+  s->notify = notify;
+  b_data_emit_changed (B_DATA (s));
+}
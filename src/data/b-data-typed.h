@@ -0,0 +1,53 @@
+/*
+ * b-data-typed.h :
+ *
+ * Copyright (C) 2003-2004 Jody Goldberg (jody@gnome.org)
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#pragma once
+
+#include "data/b-data-class.h"
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(BTypedVector,b_typed_vector,B,TYPED_VECTOR,BVector)
+
+#define B_TYPE_TYPED_VECTOR  (b_typed_vector_get_type ())
+
+BData *b_typed_vector_new (gpointer data, BElementType type, guint n, GDestroyNotify notify);
+BData *b_typed_vector_new_alloc (BElementType type, guint n);
+BData *b_typed_vector_new_copy (gconstpointer data, BElementType type, guint n);
+BData *b_typed_vector_new_mmap (const char *filename, goffset offset, BElementType type, GError **error);
+
+gpointer b_typed_vector_get_data (BTypedVector *s, BElementType *type);
+void b_typed_vector_replace_data (BTypedVector *s, gpointer data, BElementType type, guint n, GDestroyNotify notify);
+
+G_DECLARE_FINAL_TYPE(BTypedMatrix,b_typed_matrix,B,TYPED_MATRIX,BMatrix)
+
+#define B_TYPE_TYPED_MATRIX  (b_typed_matrix_get_type ())
+
+BData *b_typed_matrix_new (gpointer data, BElementType type, guint rows, guint columns, GDestroyNotify notify);
+BData *b_typed_matrix_new_alloc (BElementType type, guint rows, guint columns);
+BData *b_typed_matrix_new_copy (gconstpointer data, BElementType type, guint rows, guint columns);
+BData *b_typed_matrix_new_mmap (const char *filename, goffset offset, BElementType type, guint columns, GError **error);
+
+gpointer b_typed_matrix_get_data (BTypedMatrix *s, BElementType *type);
+void b_typed_matrix_replace_data (BTypedMatrix *s, gpointer data, BElementType type, guint rows, guint columns, GDestroyNotify notify);
+
+G_END_DECLS
@@ -21,6 +21,7 @@
  */
 
 #include "b-data-class.h"
+#include "b-data-private.h"
 #include <math.h>
 #include <string.h>
 #include <errno.h>
@@ -42,6 +43,18 @@
  *
  * Data objects also maintain a timestamp that updates when the "changed" signal
  * is emitted.
+ *
+ * Several changes can be grouped with b_data_begin_update() and
+ * b_data_end_update(), so that the "changed" signal is emitted only once, at
+ * the end.
+ *
+ * The "changed" signal itself carries no details, but a handler can call
+ * b_data_get_change() to find out which elements changed, if the emitter
+ * reported it with b_data_emit_changed_range() or b_data_emit_appended().
+ * Every emission increments the generation counter returned by
+ * b_data_get_generation(). A consumer that remembers the generation it last
+ * processed can do incremental work when the #BDataChange it receives
+ * immediately follows it, and start over otherwise.
  */
 
 typedef enum
@@ -50,13 +63,28 @@ typedef enum
   B_DATA_IS_EDITABLE = 1 << 1,
   B_DATA_SIZE_CACHED = 1 << 2,
   B_DATA_HAS_VALUE = 1 << 3,
-  B_DATA_MINMAX_CACHED = 1 << 4
+  B_DATA_MINMAX_CACHED = 1 << 4,
+  B_DATA_RANGE_CACHED = 1 << 5,
+  B_DATA_ORDER_CACHED = 1 << 6,
+  /* valid when B_DATA_ORDER_CACHED is set; NaNs are skipped when setting
+     the first three */
+  B_DATA_INCREASING = 1 << 7,
+  B_DATA_DECREASING = 1 << 8,
+  B_DATA_STRICT = 1 << 9,
+  B_DATA_HAS_NAN = 1 << 10
 } BDataFlags;
 
 typedef struct
 {
   guint32 flags;
   gint64 timestamp;
+  gint update_count;
+  gboolean pending_change;
+  BDataChange pending;
+  guint32 held;			/* caches that were valid when the pending
+				   change began */
+  BDataChange change;
+  guint64 generation;
 } BDataPrivate;
 
 enum
@@ -171,20 +199,193 @@ b_data_serialize (BData * dat, gpointer user)
   return (*klass->serialize) (dat, user);
 }
 
+/* combine a change with the ones not yet reported by a signal */
+static void
+data_add_change (BDataPrivate * priv, BDataChangeType type, guint start,
+                 guint end, guint n_dropped)
+{
+  BDataChange *p = &priv->pending;
+
+  if (!priv->pending_change)
+    {
+      p->type = type;
+      p->start = start;
+      p->end = end;
+      p->n_dropped = n_dropped;
+      priv->pending_change = TRUE;
+      priv->held = priv->flags & (B_DATA_ORDER_CACHED | B_DATA_RANGE_CACHED);
+    }
+  else if (type == B_DATA_CHANGE_RANGE && p->type == B_DATA_CHANGE_RANGE)
+    {
+      p->start = MIN (p->start, start);
+      p->end = MAX (p->end, end);
+    }
+  else if (type == B_DATA_CHANGE_APPEND && p->type == B_DATA_CHANGE_APPEND)
+    {
+      /* earlier appended elements have moved down by n_dropped */
+      p->start = (p->start > n_dropped) ? MIN (p->start - n_dropped, start) : 0;
+      p->end = end;
+      p->n_dropped += n_dropped;
+    }
+  else
+    p->type = B_DATA_CHANGE_ALL;
+}
+
+/* emit "changed" for the pending changes, unless an update is in progress */
+static void
+data_flush (BData * data)
+{
+  BDataPrivate *priv = b_data_get_instance_private (data);
+
+  if (priv->update_count > 0)
+    {
+      priv->flags &=
+        ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
+          B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
+      return;
+    }
+
+  priv->change = priv->pending;
+  priv->change.generation = ++priv->generation;
+  priv->pending_change = FALSE;
+  g_signal_emit (G_OBJECT (data), b_data_signals[CHANGED], 0);
+}
+
+static void
+data_emit (BData * data, BDataChangeType type, guint start, guint end,
+           guint n_dropped)
+{
+  BDataClass *klass = B_DATA_GET_CLASS (data);
+
+  g_return_if_fail (klass != NULL);
+
+  BDataPrivate *priv = b_data_get_instance_private (data);
+
+  data_add_change (priv, type, start, end, n_dropped);
+  data_flush (data);
+}
+
 /**
  * b_data_emit_changed :
  * @data: #BData
  *
- * Utility to emit a 'changed' signal
+ * Utility to emit a 'changed' signal. If an update is in progress (see
+ * b_data_begin_update()), the cache is invalidated but the signal is held
+ * back until the update ends.
  **/
 void
 b_data_emit_changed (BData * data)
 {
-  BDataClass *klass = B_DATA_GET_CLASS (data);
+  data_emit (data, B_DATA_CHANGE_ALL, 0, 0, 0);
+}
 
-  g_return_if_fail (klass != NULL);
+/**
+ * b_data_emit_changed_range :
+ * @data: #BData
+ * @start: index of the first changed element, or row for matrices
+ * @end: index after the last changed element, or row for matrices
+ *
+ * Like b_data_emit_changed(), but tells handlers that only the elements from
+ * @start up to @end changed and the size did not. See b_data_get_change().
+ **/
+void
+b_data_emit_changed_range (BData * data, guint start, guint end)
+{
+  g_return_if_fail (start <= end);
+  data_emit (data, B_DATA_CHANGE_RANGE, start, end, 0);
+}
 
-  g_signal_emit (G_OBJECT (data), b_data_signals[CHANGED], 0);
+/**
+ * b_data_emit_appended :
+ * @data: #BData
+ * @start: index of the first appended element, or row for matrices
+ * @end: index after the last appended element, which is the new length
+ * @n_dropped: number of elements (rows) that were removed from the beginning
+ *
+ * Like b_data_emit_changed(), but tells handlers that the elements from
+ * @start up to @end were appended, and @n_dropped elements were removed from
+ * the beginning to make room. See b_data_get_change().
+ **/
+void
+b_data_emit_appended (BData * data, guint start, guint end, guint n_dropped)
+{
+  g_return_if_fail (start <= end);
+  data_emit (data, B_DATA_CHANGE_APPEND, start, end, n_dropped);
+}
+
+/**
+ * b_data_get_change :
+ * @data: #BData
+ *
+ * Get a description of the last change to @data that was signalled. This is
+ * meant to be called from a "changed" signal handler. Changes grouped with
+ * b_data_begin_update() are merged; if they can't be described as a single
+ * range or append, the type is %B_DATA_CHANGE_ALL.
+ *
+ * Returns: (transfer none): the last change
+ **/
+const BDataChange *
+b_data_get_change (BData * data)
+{
+  g_return_val_if_fail (B_IS_DATA (data), NULL);
+  BDataPrivate *priv = b_data_get_instance_private (data);
+  return &priv->change;
+}
+
+/**
+ * b_data_get_generation :
+ * @data: #BData
+ *
+ * Get the generation counter of @data, which starts at zero and increases by
+ * one every time a "changed" signal is emitted.
+ *
+ * Returns: the generation
+ **/
+guint64
+b_data_get_generation (BData * data)
+{
+  g_return_val_if_fail (B_IS_DATA (data), 0);
+  BDataPrivate *priv = b_data_get_instance_private (data);
+  return priv->generation;
+}
+
+/**
+ * b_data_begin_update :
+ * @data: #BData
+ *
+ * Starts a group of changes to @data. Until the matching call of
+ * b_data_end_update(), b_data_emit_changed() will not emit a "changed" signal.
+ * Calls can be nested; a single "changed" signal is emitted when the
+ * outermost update ends, if anything changed in the meantime.
+ **/
+void
+b_data_begin_update (BData * data)
+{
+  g_return_if_fail (B_IS_DATA (data));
+  BDataPrivate *priv = b_data_get_instance_private (data);
+
+  g_return_if_fail (priv->update_count >= 0);
+  ++priv->update_count;
+}
+
+/**
+ * b_data_end_update :
+ * @data: #BData
+ *
+ * Ends a group of changes started with b_data_begin_update(). See
+ * b_data_begin_update() for details.
+ **/
+void
+b_data_end_update (BData * data)
+{
+  g_return_if_fail (B_IS_DATA (data));
+  BDataPrivate *priv = b_data_get_instance_private (data);
+
+  g_return_if_fail (priv->update_count > 0);
+  --priv->update_count;
+
+  if (priv->update_count == 0 && priv->pending_change)
+    data_flush (data);
 }
 
 /**
@@ -225,6 +426,33 @@ b_data_has_value (BData * data)
   return priv->flags & B_DATA_HAS_VALUE;
 }
 
+/**
+ * b_element_type_get_size :
+ * @type: #BElementType
+ *
+ * Get the size in bytes of one element of type @type.
+ *
+ * Returns: the size
+ **/
+gsize
+b_element_type_get_size (BElementType type)
+{
+  switch (type)
+    {
+    case B_ELEMENT_TYPE_DOUBLE:
+      return sizeof (double);
+    case B_ELEMENT_TYPE_FLOAT:
+      return sizeof (float);
+    case B_ELEMENT_TYPE_INT16:
+      return sizeof (gint16);
+    case B_ELEMENT_TYPE_UINT16:
+      return sizeof (guint16);
+    case B_ELEMENT_TYPE_UINT8:
+      return sizeof (guint8);
+    }
+  g_return_val_if_reached (0);
+}
+
 /**
  * b_data_get_n_dimensions :
  * @data: #BData
@@ -500,11 +728,35 @@ b_val_scalar_set_val (BValScalar * s, double val)
  * Abstract base class for data classes representing one dimensional arrays.
  */
 
+/* Index for minimum and maximum queries over ranges of a vector: the finite
+ * extrema of each block of RANGE_BLOCK elements are kept in the leaves of a
+ * bottom-up segment tree, tree[nb + k] for slot k, with tree[i] combining
+ * tree[2i] and tree[2i+1]. Element i is in block (i + origin) / RANGE_BLOCK,
+ * whose leaf is in slot block % nb. Dropping elements from the beginning
+ * moves origin up, so the blocks that remain keep their leaves and only the
+ * blocks that were appended to have to be brought up to date. */
+
+#define RANGE_BLOCK 256
+
+typedef struct
+{
+  double min, max;
+} RangeNode;
+
+typedef struct
+{
+  unsigned int nb;
+  unsigned int origin;		/* less than nb * RANGE_BLOCK */
+  RangeNode *tree;
+} RangeIndex;
+
 typedef struct
 {
   unsigned int len;
   double *values;		/* NULL = uninitialized/unsupported, nan = missing */
   double minimum, maximum;
+  RangeIndex *range;
+  unsigned int order_tie;	/* see OrderScan */
 } BVectorPrivate;
 
 /**
@@ -515,14 +767,305 @@ typedef struct
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (BVector, b_vector, B_TYPE_DATA);
 
+/* Convert the elements of @vec from @start up to @start + @len to doubles.
+ * Unless the values are loaded already, they are read one by one, since
+ * loading them all would copy a ring whose contents wrap around. */
+static void
+vector_read (BVector * vec, unsigned int start, unsigned int len, double *buf)
+{
+  BDataPrivate *priv = b_data_get_instance_private (B_DATA (vec));
+  BVectorPrivate *vpriv = b_vector_get_instance_private (vec);
+  BVectorClass const *klass = B_VECTOR_GET_CLASS (vec);
+  BElementType type;
+  unsigned int i;
+
+  if (klass->get_native)
+    {
+      const guchar *v = (*klass->get_native) (vec, &type);
+      _b_element_convert (v + start * b_element_type_get_size (type), type,
+                          buf, len);
+    }
+  else if ((priv->flags & B_DATA_CACHE_IS_VALID) && vpriv->values != NULL)
+    memcpy (buf, vpriv->values + start, len * sizeof (double));
+  else
+    for (i = 0; i < len; i++)
+      buf[i] = (*klass->get_value) (vec, start + i);
+}
+
+/* Monotonicity of a vector, cached in the B_DATA_INCREASING,
+ * B_DATA_DECREASING, B_DATA_STRICT and B_DATA_HAS_NAN flags. */
+
+#define ORDER_FLAGS (B_DATA_INCREASING | B_DATA_DECREASING | B_DATA_STRICT | \
+                     B_DATA_HAS_NAN)
+
+typedef struct
+{
+  guint32 flags;
+  gboolean have_last;
+  double last;
+  unsigned int tie;		/* index + 1 of the last element equal to the one
+				   before it, or 0 */
+} OrderScan;
+
+static void
+order_scan_block (OrderScan * o, const double *buf, unsigned int len,
+                  unsigned int first)
+{
+  unsigned int i;
+
+  for (i = 0; i < len; i++)
+    {
+      double x = buf[i];
+      if (isnan (x))
+        {
+          o->flags |= B_DATA_HAS_NAN;
+          continue;
+        }
+      if (o->have_last)
+        {
+          if (x < o->last)
+            o->flags &= ~B_DATA_INCREASING;
+          else if (x > o->last)
+            o->flags &= ~B_DATA_DECREASING;
+          else
+            {
+              o->flags &= ~B_DATA_STRICT;
+              o->tie = first + i + 1;
+            }
+        }
+      o->last = x;
+      o->have_last = TRUE;
+    }
+}
+
+static void
+order_scan (OrderScan * o, gconstpointer v, BElementType type,
+            unsigned int start, unsigned int end)
+{
+  double buf[RANGE_BLOCK];
+  gsize elsize = b_element_type_get_size (type);
+  unsigned int k;
+
+  for (k = start; k < end; k += RANGE_BLOCK)
+    {
+      unsigned int len = MIN (RANGE_BLOCK, end - k);
+      _b_element_convert ((const guchar *) v + k * elsize, type, buf, len);
+      order_scan_block (o, buf, len, k);
+    }
+}
+
+static guint32
+vector_get_order (BVector * vec)
+{
+  BDataPrivate *priv = b_data_get_instance_private (B_DATA (vec));
+  BVectorPrivate *vpriv = b_vector_get_instance_private (vec);
+  BElementType type;
+
+  if (!(priv->flags & B_DATA_ORDER_CACHED))
+    {
+      unsigned int n = b_vector_get_len (vec);
+      gconstpointer v = b_vector_get_native_values (vec, &type);
+      OrderScan o = { B_DATA_INCREASING | B_DATA_DECREASING | B_DATA_STRICT,
+                      FALSE, 0.0, 0 };
+
+      if (v != NULL)
+        order_scan (&o, v, type, 0, n);
+      if (!o.have_last)
+        o.flags &= ~(B_DATA_INCREASING | B_DATA_DECREASING);
+      vpriv->order_tie = o.tie;
+      priv->flags = (priv->flags & ~ORDER_FLAGS) | o.flags | B_DATA_ORDER_CACHED;
+      /* in the middle of an update, the pending change no longer follows
+         the cached order */
+      priv->held &= ~B_DATA_ORDER_CACHED;
+    }
+  return priv->flags & ORDER_FLAGS;
+}
+
+/* After elements were appended from @start up to @end, only the new elements
+ * need to be checked against the order that was cached before. Dropping
+ * elements from the beginning keeps a vector sorted, strictly or not, and
+ * makes it strict if the last tie is dropped, but might make an unsorted one
+ * sorted, so in that case the order is left to be rescanned. */
+static void
+vector_update_order (BVector * vec, guint32 old, const BDataChange * change)
+{
+  BDataPrivate *priv = b_data_get_instance_private (B_DATA (vec));
+  BVectorPrivate *vpriv = b_vector_get_instance_private (vec);
+  double buf[RANGE_BLOCK];
+  unsigned int start = change->start, end = change->end, k;
+  unsigned int dropped = change->n_dropped;
+  gboolean sorted = (old & (B_DATA_INCREASING | B_DATA_DECREASING)) != 0;
+
+  if (start == 0 || (old & B_DATA_HAS_NAN) || end > b_vector_get_len (vec)
+      || (dropped > 0 && !sorted))
+    return;
+
+  /* a tie is kept if the element before it is */
+  OrderScan o = { old & ORDER_FLAGS, TRUE, 0.0,
+                  vpriv->order_tie >= dropped + 2 ? vpriv->order_tie - dropped : 0 };
+  if (sorted && o.tie == 0)
+    o.flags |= B_DATA_STRICT;
+  vector_read (vec, start - 1, 1, &o.last);
+  for (k = start; k < end; k += RANGE_BLOCK)
+    {
+      unsigned int len = MIN (RANGE_BLOCK, end - k);
+      vector_read (vec, k, len, buf);
+      order_scan_block (&o, buf, len, k);
+    }
+  vpriv->order_tie = o.tie;
+  priv->flags = (priv->flags & ~ORDER_FLAGS) | o.flags | B_DATA_ORDER_CACHED;
+}
+
+/* set the leaf of @block from the elements of @vec in it, and the nodes
+ * above it */
+static void
+range_index_set_block (RangeIndex * r, BVector * vec, unsigned int n,
+                       gsize block)
+{
+  double buf[RANGE_BLOCK];
+  gsize lo = block * RANGE_BLOCK, hi = lo + RANGE_BLOCK;
+  unsigned int first = lo > r->origin ? lo - r->origin : 0;
+  unsigned int last = MIN (hi - r->origin, n);
+  unsigned int k = r->nb + block % r->nb;
+
+  vector_read (vec, first, last - first, buf);
+  _b_minmax_double (buf, last - first, &r->tree[k].min, &r->tree[k].max);
+  for (k >>= 1; k > 0; k >>= 1)
+    {
+      r->tree[k].min = MIN (r->tree[2 * k].min, r->tree[2 * k + 1].min);
+      r->tree[k].max = MAX (r->tree[2 * k].max, r->tree[2 * k + 1].max);
+    }
+}
+
+/* combine the leaves in slots @l up to @h into @mn and @mx */
+static void
+range_index_query (const RangeIndex * r, unsigned int l, unsigned int h,
+                   double *mn, double *mx)
+{
+  for (l += r->nb, h += r->nb; l < h; l >>= 1, h >>= 1)
+    {
+      if (l & 1)
+        {
+          *mn = MIN (*mn, r->tree[l].min);
+          *mx = MAX (*mx, r->tree[l].max);
+          l++;
+        }
+      if (h & 1)
+        {
+          h--;
+          *mn = MIN (*mn, r->tree[h].min);
+          *mx = MAX (*mx, r->tree[h].max);
+        }
+    }
+}
+
+static RangeIndex *
+vector_get_range_index (BVector * vec)
+{
+  BDataPrivate *priv = b_data_get_instance_private (B_DATA (vec));
+  BVectorPrivate *vpriv = b_vector_get_instance_private (vec);
+  BElementType type;
+  double buf[RANGE_BLOCK];
+  unsigned int k;
+
+  if (vpriv->range && (priv->flags & B_DATA_RANGE_CACHED))
+    return vpriv->range;
+
+  unsigned int n = b_vector_get_len (vec);
+  const guchar *v = b_vector_get_native_values (vec, &type);
+  gsize elsize = b_element_type_get_size (type);
+  unsigned int used = (n + RANGE_BLOCK - 1) / RANGE_BLOCK;
+  /* room for the vector to grow, or for a ring to scroll through a block
+     that is only partly in it */
+  unsigned int nb = 2 * used + 1;
+
+  if (vpriv->range == NULL)
+    vpriv->range = g_new0 (RangeIndex, 1);
+  RangeIndex *r = vpriv->range;
+  if (r->nb != nb || r->tree == NULL)
+    {
+      g_free (r->tree);
+      r->tree = g_new (RangeNode, 2 * nb);
+      r->nb = nb;
+    }
+  r->origin = 0;
+
+  for (k = 0; k < nb; k++)
+    {
+      RangeNode *leaf = &r->tree[nb + k];
+      if (k < used)
+        {
+          unsigned int len = MIN (RANGE_BLOCK, n - k * RANGE_BLOCK);
+          _b_element_convert (v + (gsize) k * RANGE_BLOCK * elsize, type,
+                              buf, len);
+          _b_minmax_double (buf, len, &leaf->min, &leaf->max);
+        }
+      else
+        {
+          leaf->min = DBL_MAX;
+          leaf->max = -DBL_MAX;
+        }
+    }
+  for (k = nb - 1; k > 0; k--)
+    {
+      r->tree[k].min = MIN (r->tree[2 * k].min, r->tree[2 * k + 1].min);
+      r->tree[k].max = MAX (r->tree[2 * k].max, r->tree[2 * k + 1].max);
+    }
+
+  priv->flags |= B_DATA_RANGE_CACHED;
+  /* in the middle of an update, the pending change no longer follows the
+     index */
+  priv->held &= ~B_DATA_RANGE_CACHED;
+  return r;
+}
+
+/* Bring the range index up to date after an append or a change to a range
+ * of elements, by setting the leaves of the blocks that hold them. Returns
+ * FALSE if the index has to be rebuilt instead. */
+static gboolean
+vector_update_range (BVector * vec, const BDataChange * change)
+{
+  BVectorPrivate *vpriv = b_vector_get_instance_private (vec);
+  RangeIndex *r = vpriv->range;
+  unsigned int n = b_vector_get_len (vec);
+  gsize block;
+
+  if (r == NULL || change->end > n)
+    return FALSE;
+  if (change->type == B_DATA_CHANGE_APPEND)
+    r->origin = (r->origin + (gsize) change->n_dropped)
+      % ((gsize) r->nb * RANGE_BLOCK);
+  /* the blocks the vector spans must all have their own slots */
+  if (r->origin % RANGE_BLOCK + (gsize) n > (gsize) r->nb * RANGE_BLOCK)
+    return FALSE;
+
+  if (change->start < change->end)
+    for (block = (change->start + (gsize) r->origin) / RANGE_BLOCK;
+         block <= (change->end - 1 + (gsize) r->origin) / RANGE_BLOCK;
+         block++)
+      range_index_set_block (r, vec, n, block);
+  return TRUE;
+}
+
 static void
 _data_array_emit_changed (BData * data)
 {
   BDataPrivate *priv = b_data_get_instance_private (data);
+  guint32 old = priv->flags;
   priv->timestamp = g_get_real_time ();
   priv->flags &=
     ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
-      B_DATA_MINMAX_CACHED);
+      B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
+  /* during an update the caches are invalidated as the data changes, but the
+     order and range index that were cached before it can still be brought
+     up to date with the merged change */
+  if ((priv->held & B_DATA_ORDER_CACHED) && B_IS_VECTOR (data)
+      && priv->change.type == B_DATA_CHANGE_APPEND)
+    vector_update_order (B_VECTOR (data), old, &priv->change);
+  if ((priv->held & B_DATA_RANGE_CACHED) && B_IS_VECTOR (data)
+      && priv->change.type != B_DATA_CHANGE_ALL
+      && vector_update_range (B_VECTOR (data), &priv->change))
+    priv->flags |= B_DATA_RANGE_CACHED;
 }
 
 static void
@@ -534,6 +1077,11 @@ _vector_finalize (GObject * dat)
 
   if (vec_class->replace_cache == NULL)
     g_clear_pointer(&vpriv->values,g_free);
+  if (vpriv->range)
+    {
+      g_free (vpriv->range->tree);
+      g_clear_pointer (&vpriv->range, g_free);
+    }
 
   GObjectClass *obj_class = G_OBJECT_CLASS (b_vector_parent_class);
 
@@ -703,81 +1251,25 @@ b_vector_get_str (BVector * vec, unsigned int i, const gchar * format)
   return format_val (val, format);
 }
 
-static int
-range_increasing (double const *xs, int n)
-{
-  int i = 0;
-  double last;
-  g_return_val_if_fail (n == 0 || xs != NULL, 0);
-  while (i < n && isnan (xs[i]))
-    i++;
-  if (i == n)
-    return 0;
-  last = xs[i];
-  for (i = i + 1; i < n; i++)
-    {
-      if (isnan (xs[i]))
-        continue;
-      if (last >= xs[i])
-        return 0;
-      last = xs[i];
-    }
-  return 1;
-}
-
-static int
-range_decreasing (double const *xs, int n)
-{
-  int i = 0;
-  double last;
-  g_return_val_if_fail (n == 0 || xs != NULL, 0);
-  while (i < n && isnan (xs[i]))
-    i++;
-  if (i == n)
-    return 0;
-  last = xs[i];
-  for (i = i + 1; i < n; i++)
-    {
-      if (isnan (xs[i]))
-        continue;
-      if (last <= xs[i])
-        return 0;
-      last = xs[i];
-    }
-  return 1;
-}
-
-static int
-range_vary_uniformly (double const *xs, int n)
-{
-  return range_increasing (xs, n) || range_decreasing (xs, n);
-}
-
 /**
  * b_vector_is_varying_uniformly :
  * @data: #BVector
  *
- * Returns whether elements of @data only increase or only decrease.
+ * Returns whether elements of @data only increase or only decrease. NaN
+ * elements are skipped. The result is cached until @data changes, and is
+ * updated incrementally when elements are appended (see
+ * b_data_emit_appended()).
  *
  * Returns: TRUE if elements of @data strictly increase or decrease.
  **/
 gboolean
 b_vector_is_varying_uniformly (BVector * data)
 {
-  double const *values;
-  unsigned int n_values;
-
   g_return_val_if_fail (B_IS_VECTOR (data), FALSE);
 
-  values = b_vector_get_values (data);
-  if (values == NULL)
-    return FALSE;
-
-  n_values = b_vector_get_len (data);
-  if (n_values < 1)
-    return FALSE;
-
-  return range_vary_uniformly (values, n_values);
+  guint32 order = vector_get_order (data);
+  return (order & (B_DATA_INCREASING | B_DATA_DECREASING))
+    && (order & B_DATA_STRICT);
 }
 
 /**
@@ -801,20 +1293,20 @@ b_vector_get_minmax (BVector * vec, double *min, double *max)
       if(i==0)
         return;
 
-      const double *v = b_vector_get_values (vec);
-      if (v == NULL)
-        return;
-
       double minimum = DBL_MAX, maximum = -DBL_MAX;
+      BVectorClass const *klass = B_VECTOR_GET_CLASS (vec);
 
-      while (i-- > 0)
+      if (klass->load_minmax)
+        {
+          (*klass->load_minmax) (vec, &minimum, &maximum);
+        }
+      else
         {
-          if (!isfinite (v[i]))
-            continue;
-          if (minimum > v[i])
-            minimum = v[i];
-          if (maximum < v[i])
-            maximum = v[i];
+          const double *v = b_vector_get_values (vec);
+          if (v == NULL)
+            return;
+
+          _b_minmax_double (v, i, &minimum, &maximum);
         }
       vpriv->minimum = minimum;
       vpriv->maximum = maximum;
@@ -827,6 +1319,273 @@ b_vector_get_minmax (BVector * vec, double *min, double *max)
     *max = vpriv->maximum;
 }
 
+/**
+ * b_vector_get_range_minmax :
+ * @vec: #BVector
+ * @start: index of the first element
+ * @end: index after the last element
+ * @min: (out)(nullable): return location for minimum value, or @NULL
+ * @max: (out)(nullable): return location for maximum value, or @NULL
+ *
+ * Get the minimum and maximum finite values among the elements of @vec from
+ * @start up to @end. The first call builds an index in O(n) time; after that
+ * each call takes O(log n) time. Appending to @vec, or changing a range of
+ * it with b_data_emit_changed_range(), only updates the index for the
+ * elements that changed; other changes rebuild it.
+ *
+ * Returns: %TRUE if there is at least one finite value in the range. If not,
+ *   @min is set to DBL_MAX and @max to -DBL_MAX.
+ **/
+gboolean
+b_vector_get_range_minmax (BVector * vec, unsigned int start,
+                           unsigned int end, double *min, double *max)
+{
+  double buf[RANGE_BLOCK];
+  double mn = DBL_MAX, mx = -DBL_MAX, a, b;
+
+  g_return_val_if_fail (B_IS_VECTOR (vec), FALSE);
+
+  end = MIN (end, b_vector_get_len (vec));
+  if (start < end)
+    {
+      RangeIndex *r = vector_get_range_index (vec);
+      gsize bs = (start + (gsize) r->origin) / RANGE_BLOCK;
+      gsize be = (end - 1 + (gsize) r->origin) / RANGE_BLOCK;
+
+      if (bs == be)
+        {
+          vector_read (vec, start, end - start, buf);
+          _b_minmax_double (buf, end - start, &mn, &mx);
+        }
+      else
+        {
+          /* partial blocks at both ends */
+          unsigned int lo = (bs + 1) * RANGE_BLOCK - r->origin;
+          vector_read (vec, start, lo - start, buf);
+          _b_minmax_double (buf, lo - start, &mn, &mx);
+          unsigned int hi = be * RANGE_BLOCK - r->origin;
+          vector_read (vec, hi, end - hi, buf);
+          _b_minmax_double (buf, end - hi, &a, &b);
+          mn = MIN (mn, a);
+          mx = MAX (mx, b);
+
+          /* whole blocks from the tree, whose slots may wrap around */
+          unsigned int l = (bs + 1) % r->nb, count = be - bs - 1;
+          if (l + count > r->nb)
+            {
+              range_index_query (r, l, r->nb, &mn, &mx);
+              range_index_query (r, 0, l + count - r->nb, &mn, &mx);
+            }
+          else
+            range_index_query (r, l, l + count, &mn, &mx);
+        }
+    }
+
+  if (min != NULL)
+    *min = mn;
+  if (max != NULL)
+    *max = mx;
+  return mn <= mx;
+}
+
+/* For a vector sorted in direction @up (ascending) or not (descending), find
+ * the first element that is past @x, i.e. greater than (@strict) or not less
+ * than @x for ascending vectors. */
+static unsigned int
+vector_bisect (gconstpointer v, BElementType type, unsigned int n,
+               gboolean up, double x, gboolean strict)
+{
+  unsigned int lo = 0, hi = n, mid;
+
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      double y = _b_element_get (v, type, mid);
+      gboolean before;
+      if (up)
+        before = strict ? y <= x : y < x;
+      else
+        before = strict ? y >= x : y > x;
+      if (before)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* returns 1 for ascending, -1 for descending and 0 for vectors that can't be
+   searched */
+static int
+vector_get_direction (BVector * vec)
+{
+  guint32 order = vector_get_order (vec);
+  if (order & B_DATA_HAS_NAN)
+    return 0;
+  if (order & B_DATA_INCREASING)
+    return 1;
+  if (order & B_DATA_DECREASING)
+    return -1;
+  return 0;
+}
+
+/**
+ * b_vector_is_sorted :
+ * @vec: #BVector
+ *
+ * Whether @vec is sorted in ascending or descending order, with no NaN
+ * elements, so that it can be searched with b_vector_find_range() and
+ * b_vector_search(). The order is found once and kept until @vec changes,
+ * and appending to a sorted vector only checks the new elements.
+ *
+ * Returns: %TRUE if @vec is sorted
+ **/
+gboolean
+b_vector_is_sorted (BVector * vec)
+{
+  g_return_val_if_fail (B_IS_VECTOR (vec), FALSE);
+
+  return vector_get_direction (vec) != 0;
+}
+
+/**
+ * b_vector_find_range :
+ * @vec: #BVector
+ * @a: lower limit
+ * @b: upper limit
+ * @start: (out): return location for the index of the first element in the
+ *   range
+ * @end: (out): return location for the index after the last element in the
+ *   range
+ *
+ * Find the elements of a sorted vector that lie between @a and @b. If @vec
+ * is sorted in ascending or descending order, the search takes O(log n) time
+ * (after the order of @vec is found and cached, see
+ * b_vector_is_varying_uniformly()).
+ *
+ * Returns: %TRUE if @vec is sorted and the range was found, %FALSE if @vec
+ *   is not sorted or contains NaN.
+ **/
+gboolean
+b_vector_find_range (BVector * vec, double a, double b, unsigned int *start,
+                     unsigned int *end)
+{
+  BElementType type;
+
+  g_return_val_if_fail (B_IS_VECTOR (vec), FALSE);
+  g_return_val_if_fail (start != NULL && end != NULL, FALSE);
+
+  int dir = vector_get_direction (vec);
+  if (dir == 0)
+    return FALSE;
+
+  unsigned int n = b_vector_get_len (vec);
+  gconstpointer v = b_vector_get_native_values (vec, &type);
+
+  if (a > b)
+    {
+      double t = a;
+      a = b;
+      b = t;
+    }
+  if (dir > 0)
+    {
+      *start = vector_bisect (v, type, n, TRUE, a, FALSE);
+      *end = vector_bisect (v, type, n, TRUE, b, TRUE);
+    }
+  else
+    {
+      *start = vector_bisect (v, type, n, FALSE, b, FALSE);
+      *end = vector_bisect (v, type, n, FALSE, a, TRUE);
+    }
+  return TRUE;
+}
+
+/**
+ * b_vector_search :
+ * @vec: #BVector
+ * @x: value to search for
+ * @mode: which element to return
+ *
+ * Find the element of a sorted vector that is nearest to @x, or the one with
+ * the largest value not greater than @x (%B_SEARCH_LOWER) or the smallest
+ * value not less than @x (%B_SEARCH_UPPER). This works for vectors sorted in
+ * ascending or descending order and takes O(log n) time.
+ *
+ * Returns: the index of the element, or -1 if there is no such element or
+ *   @vec is not sorted.
+ **/
+int
+b_vector_search (BVector * vec, double x, BSearchMode mode)
+{
+  BElementType type;
+  int lower, upper;
+
+  g_return_val_if_fail (B_IS_VECTOR (vec), -1);
+
+  int dir = vector_get_direction (vec);
+  unsigned int n = b_vector_get_len (vec);
+  if (dir == 0 || n == 0 || isnan (x))
+    return -1;
+
+  gconstpointer v = b_vector_get_native_values (vec, &type);
+  if (dir > 0)
+    {
+      lower = (int) vector_bisect (v, type, n, TRUE, x, TRUE) - 1;
+      upper = vector_bisect (v, type, n, TRUE, x, FALSE);
+    }
+  else
+    {
+      lower = vector_bisect (v, type, n, FALSE, x, FALSE);
+      upper = (int) vector_bisect (v, type, n, FALSE, x, TRUE) - 1;
+    }
+  if (lower >= (int) n)
+    lower = -1;
+  if (upper >= (int) n)
+    upper = -1;
+
+  switch (mode)
+    {
+    case B_SEARCH_LOWER:
+      return lower;
+    case B_SEARCH_UPPER:
+      return upper;
+    default:
+      if (lower < 0)
+        return upper;
+      if (upper < 0)
+        return lower;
+      return (x - _b_element_get (v, type, lower) <=
+              _b_element_get (v, type, upper) - x) ? lower : upper;
+    }
+}
+
+/**
+ * b_vector_get_native_values :
+ * @vec: #BVector
+ * @type: (out): return location for the element type
+ *
+ * Get the array of values of @vec in the type they are stored in, avoiding a
+ * conversion to double precision. For vectors that store doubles, this is the
+ * same as b_vector_get_values().
+ *
+ * Returns: (transfer none): the values, with b_vector_get_len() elements of
+ *   type @type.
+ **/
+gconstpointer
+b_vector_get_native_values (BVector * vec, BElementType * type)
+{
+  g_return_val_if_fail (B_IS_VECTOR (vec), NULL);
+  g_return_val_if_fail (type != NULL, NULL);
+  BVectorClass const *klass = B_VECTOR_GET_CLASS (vec);
+
+  if (klass->get_native)
+    return (*klass->get_native) (vec, type);
+
+  *type = B_ELEMENT_TYPE_DOUBLE;
+  return b_vector_get_values (vec);
+}
+
 /**
  * b_vector_replace_cache :
  * @vec: #BVector
@@ -857,7 +1616,7 @@ b_vector_replace_cache (BVector * vec, unsigned int len)
     {
       priv->flags &=
         ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
-          B_DATA_MINMAX_CACHED);
+          B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
       return (*klass->replace_cache) (vec, len);
     }
 
@@ -866,7 +1625,7 @@ b_vector_replace_cache (BVector * vec, unsigned int len)
 
   priv->flags &=
     ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
-      B_DATA_MINMAX_CACHED);
+      B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
 
   return vpriv->values;
 }
@@ -1158,25 +1917,28 @@ b_matrix_get_minmax (BMatrix * mat, double *min, double *max)
   BMatrixPrivate *mpriv = b_matrix_get_instance_private (mat);
   if (!(priv->flags & B_DATA_MINMAX_CACHED))
     {
-      const double *v = b_matrix_get_values (mat);
-
       double minimum = DBL_MAX, maximum = -DBL_MAX;
 
       BMatrixSize s = b_matrix_get_size (mat);
       unsigned int i = s.rows * s.columns;
 
-      if(i==0 || v==NULL)
+      if(i==0)
         return;
 
-      while (i-- > 0)
+      BMatrixClass const *klass = B_MATRIX_GET_CLASS (mat);
+
+      if (klass->load_minmax)
         {
-          if (!isfinite (v[i]))
-            continue;
-          if (minimum > v[i])
-            minimum = v[i];
-          if (maximum < v[i])
-            maximum = v[i];
-          }
+          (*klass->load_minmax) (mat, &minimum, &maximum);
+        }
+      else
+        {
+          const double *v = b_matrix_get_values (mat);
+          if (v == NULL)
+            return;
+
+          _b_minmax_double (v, i, &minimum, &maximum);
+        }
       mpriv->minimum = minimum;
       mpriv->maximum = maximum;
       priv->flags |= B_DATA_MINMAX_CACHED;
@@ -1188,6 +1950,32 @@ b_matrix_get_minmax (BMatrix * mat, double *min, double *max)
     *max = mpriv->maximum;
 }
 
+/**
+ * b_matrix_get_native_values :
+ * @mat: #BMatrix
+ * @type: (out): return location for the element type
+ *
+ * Get the array of values of @mat in the type they are stored in, avoiding a
+ * conversion to double precision. For matrices that store doubles, this is
+ * the same as b_matrix_get_values().
+ *
+ * Returns: (transfer none): the values, in row-major order, with elements of
+ *   type @type.
+ **/
+gconstpointer
+b_matrix_get_native_values (BMatrix * mat, BElementType * type)
+{
+  g_return_val_if_fail (B_IS_MATRIX (mat), NULL);
+  g_return_val_if_fail (type != NULL, NULL);
+  BMatrixClass const *klass = B_MATRIX_GET_CLASS (mat);
+
+  if (klass->get_native)
+    return (*klass->get_native) (mat, type);
+
+  *type = B_ELEMENT_TYPE_DOUBLE;
+  return b_matrix_get_values (mat);
+}
+
 /**
  * b_matrix_replace_cache :
  * @mat: #BMatrix
@@ -1220,7 +2008,7 @@ b_matrix_replace_cache (BMatrix * mat, unsigned len)
     {
       priv->flags &=
         ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
-          B_DATA_MINMAX_CACHED);
+          B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
       return (*klass->replace_cache) (mat, len);
     }
 
@@ -1229,7 +2017,7 @@ b_matrix_replace_cache (BMatrix * mat, unsigned len)
 
   priv->flags &=
     ~(B_DATA_CACHE_IS_VALID | B_DATA_SIZE_CACHED | B_DATA_HAS_VALUE |
-      B_DATA_MINMAX_CACHED);
+      B_DATA_MINMAX_CACHED | B_DATA_RANGE_CACHED | B_DATA_ORDER_CACHED);
 
   return mpriv->values;
 }
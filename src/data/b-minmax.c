@@ -0,0 +1,332 @@
+/*
+ * b-minmax.c :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "b-data-private.h"
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+/* Minimum and maximum of the finite values in an array.
+ *
+ * The vector kernels replace non-finite lanes by +inf (for the minimum) or
+ * -inf (for the maximum) before reducing, so NaN and Inf are skipped without
+ * branching. A value is finite if its absolute value compares less than
+ * infinity, which is false for NaN. The kernel is picked once, at the first
+ * call, according to what the CPU supports. */
+
+typedef gboolean (*MinMaxFunc) (const double *v, gsize n, double *min, double *max);
+
+static gboolean
+finish (double minimum, double maximum, double *min, double *max)
+{
+  /* keep the sentinels used by the original scalar loop */
+  if (minimum > maximum)
+    {
+      *min = DBL_MAX;
+      *max = -DBL_MAX;
+      return FALSE;
+    }
+  *min = minimum;
+  *max = maximum;
+  return TRUE;
+}
+
+static gboolean
+minmax_scalar (const double *v, gsize n, double *min, double *max)
+{
+  double minimum = INFINITY, maximum = -INFINITY;
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      if (minimum > v[i])
+        minimum = v[i];
+      if (maximum < v[i])
+        maximum = v[i];
+    }
+  return finish (minimum, maximum, min, max);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+
+static gboolean
+minmax_sse2 (const double *v, gsize n, double *min, double *max)
+{
+  const __m128d inf = _mm_set1_pd (INFINITY);
+  const __m128d ninf = _mm_set1_pd (-INFINITY);
+  const __m128d absmask = _mm_castsi128_pd (_mm_set1_epi64x (0x7fffffffffffffffLL));
+  __m128d lo0 = inf, lo1 = inf, hi0 = ninf, hi1 = ninf;
+  gsize i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      __m128d x0 = _mm_loadu_pd (&v[i]);
+      __m128d x1 = _mm_loadu_pd (&v[i + 2]);
+      __m128d f0 = _mm_cmplt_pd (_mm_and_pd (x0, absmask), inf);
+      __m128d f1 = _mm_cmplt_pd (_mm_and_pd (x1, absmask), inf);
+      lo0 = _mm_min_pd (lo0, _mm_or_pd (_mm_and_pd (f0, x0), _mm_andnot_pd (f0, inf)));
+      lo1 = _mm_min_pd (lo1, _mm_or_pd (_mm_and_pd (f1, x1), _mm_andnot_pd (f1, inf)));
+      hi0 = _mm_max_pd (hi0, _mm_or_pd (_mm_and_pd (f0, x0), _mm_andnot_pd (f0, ninf)));
+      hi1 = _mm_max_pd (hi1, _mm_or_pd (_mm_and_pd (f1, x1), _mm_andnot_pd (f1, ninf)));
+    }
+  lo0 = _mm_min_pd (lo0, lo1);
+  hi0 = _mm_max_pd (hi0, hi1);
+  lo0 = _mm_min_sd (lo0, _mm_unpackhi_pd (lo0, lo0));
+  hi0 = _mm_max_sd (hi0, _mm_unpackhi_pd (hi0, hi0));
+
+  double minimum = _mm_cvtsd_f64 (lo0), maximum = _mm_cvtsd_f64 (hi0);
+  for (; i < n; i++)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      if (minimum > v[i])
+        minimum = v[i];
+      if (maximum < v[i])
+        maximum = v[i];
+    }
+  return finish (minimum, maximum, min, max);
+}
+
+__attribute__((target ("avx2")))
+static gboolean
+minmax_avx2 (const double *v, gsize n, double *min, double *max)
+{
+  const __m256d inf = _mm256_set1_pd (INFINITY);
+  const __m256d ninf = _mm256_set1_pd (-INFINITY);
+  const __m256d absmask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL));
+  __m256d lo0 = inf, lo1 = inf, hi0 = ninf, hi1 = ninf;
+  gsize i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    {
+      __m256d x0 = _mm256_loadu_pd (&v[i]);
+      __m256d x1 = _mm256_loadu_pd (&v[i + 4]);
+      __m256d f0 = _mm256_cmp_pd (_mm256_and_pd (x0, absmask), inf, _CMP_LT_OQ);
+      __m256d f1 = _mm256_cmp_pd (_mm256_and_pd (x1, absmask), inf, _CMP_LT_OQ);
+      lo0 = _mm256_min_pd (lo0, _mm256_blendv_pd (inf, x0, f0));
+      lo1 = _mm256_min_pd (lo1, _mm256_blendv_pd (inf, x1, f1));
+      hi0 = _mm256_max_pd (hi0, _mm256_blendv_pd (ninf, x0, f0));
+      hi1 = _mm256_max_pd (hi1, _mm256_blendv_pd (ninf, x1, f1));
+    }
+  lo0 = _mm256_min_pd (lo0, lo1);
+  hi0 = _mm256_max_pd (hi0, hi1);
+  __m128d lo = _mm_min_pd (_mm256_castpd256_pd128 (lo0), _mm256_extractf128_pd (lo0, 1));
+  __m128d hi = _mm_max_pd (_mm256_castpd256_pd128 (hi0), _mm256_extractf128_pd (hi0, 1));
+  lo = _mm_min_sd (lo, _mm_unpackhi_pd (lo, lo));
+  hi = _mm_max_sd (hi, _mm_unpackhi_pd (hi, hi));
+
+  double minimum = _mm_cvtsd_f64 (lo), maximum = _mm_cvtsd_f64 (hi);
+  for (; i < n; i++)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      if (minimum > v[i])
+        minimum = v[i];
+      if (maximum < v[i])
+        maximum = v[i];
+    }
+  return finish (minimum, maximum, min, max);
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+
+static gboolean
+minmax_neon (const double *v, gsize n, double *min, double *max)
+{
+  const float64x2_t inf = vdupq_n_f64 (INFINITY);
+  const float64x2_t ninf = vdupq_n_f64 (-INFINITY);
+  float64x2_t lo0 = inf, lo1 = inf, hi0 = ninf, hi1 = ninf;
+  gsize i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      float64x2_t x0 = vld1q_f64 (&v[i]);
+      float64x2_t x1 = vld1q_f64 (&v[i + 2]);
+      uint64x2_t f0 = vcltq_f64 (vabsq_f64 (x0), inf);
+      uint64x2_t f1 = vcltq_f64 (vabsq_f64 (x1), inf);
+      lo0 = vminq_f64 (lo0, vbslq_f64 (f0, x0, inf));
+      lo1 = vminq_f64 (lo1, vbslq_f64 (f1, x1, inf));
+      hi0 = vmaxq_f64 (hi0, vbslq_f64 (f0, x0, ninf));
+      hi1 = vmaxq_f64 (hi1, vbslq_f64 (f1, x1, ninf));
+    }
+
+  double minimum = vminvq_f64 (vminq_f64 (lo0, lo1));
+  double maximum = vmaxvq_f64 (vmaxq_f64 (hi0, hi1));
+  for (; i < n; i++)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      if (minimum > v[i])
+        minimum = v[i];
+      if (maximum < v[i])
+        maximum = v[i];
+    }
+  return finish (minimum, maximum, min, max);
+}
+#endif
+
+static MinMaxFunc
+choose_minmax (void)
+{
+#if defined(HAVE_X86_KERNELS)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    return minmax_avx2;
+  return minmax_sse2;
+#elif defined(HAVE_NEON_KERNELS)
+  return minmax_neon;
+#else
+  return minmax_scalar;
+#endif
+}
+
+/* Find the minimum and maximum of the finite values in @v. If there are none,
+ * @min is set to DBL_MAX and @max to -DBL_MAX and FALSE is returned. */
+gboolean
+_b_minmax_double (const double *v, gsize n, double *min, double *max)
+{
+  static MinMaxFunc func = NULL;
+  MinMaxFunc f = g_atomic_pointer_get (&func);
+
+  if (G_UNLIKELY (f == NULL))
+    {
+      f = choose_minmax ();
+      g_atomic_pointer_set (&func, f);
+    }
+  return f (v, n, min, max);
+}
+
+#define MINMAX_INT(T)                                        \
+  static gboolean                                            \
+  minmax_##T (const T *v, gsize n, double *min, double *max) \
+  {                                                          \
+    gsize i;                                                 \
+    T minimum, maximum;                                      \
+    if (n == 0)                                              \
+      return finish (DBL_MAX, -DBL_MAX, min, max);           \
+    minimum = maximum = v[0];                                \
+    for (i = 1; i < n; i++)                                  \
+      {                                                      \
+        minimum = MIN (minimum, v[i]);                       \
+        maximum = MAX (maximum, v[i]);                       \
+      }                                                      \
+    return finish (minimum, maximum, min, max);              \
+  }
+
+MINMAX_INT (gint16)
+MINMAX_INT (guint16)
+MINMAX_INT (guint8)
+
+static gboolean
+minmax_float (const float *v, gsize n, double *min, double *max)
+{
+  float minimum = FLT_MAX, maximum = -FLT_MAX;
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      minimum = MIN (minimum, v[i]);
+      maximum = MAX (maximum, v[i]);
+    }
+  return finish (minimum, maximum, min, max);
+}
+
+/* Like _b_minmax_double() for an array of @n elements of type @type. Integer
+ * types are scanned without conversion to double. */
+gboolean
+_b_minmax_typed (gconstpointer v, BElementType type, gsize n, double *min,
+                 double *max)
+{
+  switch (type)
+    {
+    case B_ELEMENT_TYPE_DOUBLE:
+      return _b_minmax_double (v, n, min, max);
+    case B_ELEMENT_TYPE_FLOAT:
+      return minmax_float (v, n, min, max);
+    case B_ELEMENT_TYPE_INT16:
+      return minmax_gint16 (v, n, min, max);
+    case B_ELEMENT_TYPE_UINT16:
+      return minmax_guint16 (v, n, min, max);
+    case B_ELEMENT_TYPE_UINT8:
+      return minmax_guint8 (v, n, min, max);
+    }
+  g_return_val_if_reached (finish (DBL_MAX, -DBL_MAX, min, max));
+}
+
+/* Get element @i of an array of type @type. */
+double
+_b_element_get (gconstpointer data, BElementType type, gsize i)
+{
+  switch (type)
+    {
+    case B_ELEMENT_TYPE_DOUBLE:
+      return ((const double *) data)[i];
+    case B_ELEMENT_TYPE_FLOAT:
+      return ((const float *) data)[i];
+    case B_ELEMENT_TYPE_INT16:
+      return ((const gint16 *) data)[i];
+    case B_ELEMENT_TYPE_UINT16:
+      return ((const guint16 *) data)[i];
+    case B_ELEMENT_TYPE_UINT8:
+      return ((const guint8 *) data)[i];
+    }
+  return NAN;
+}
+
+#define CONVERT(T)                             \
+  {                                            \
+    const T *t = in;                           \
+    for (i = 0; i < n; i++)                    \
+      out[i] = t[i];                           \
+  }                                            \
+  break
+
+/* Convert @n elements of type @type to double. */
+void
+_b_element_convert (gconstpointer in, BElementType type, double *out, gsize n)
+{
+  gsize i;
+
+  switch (type)
+    {
+    case B_ELEMENT_TYPE_DOUBLE:
+      if (out != in)
+        memcpy (out, in, n * sizeof (double));
+      break;
+    case B_ELEMENT_TYPE_FLOAT:
+      CONVERT (float);
+    case B_ELEMENT_TYPE_INT16:
+      CONVERT (gint16);
+    case B_ELEMENT_TYPE_UINT16:
+      CONVERT (guint16);
+    case B_ELEMENT_TYPE_UINT8:
+      CONVERT (guint8);
+    }
+}
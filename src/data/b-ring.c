@@ -20,7 +20,9 @@
  */
 
 #include "b-ring.h"
+#include "b-data-private.h"
 #include <math.h>
+#include <float.h>
 
 #include <string.h>
 #include <errno.h>
@@ -40,48 +42,399 @@
  * emit a "changed" signal, the new value is appended to the #BRingVector or
  * #BRingMatrix, respectively.
  *
+ * The minimum and maximum values are maintained incrementally as elements or
+ * rows are appended, so autoscaling a plot of a ring does not require
+ * rescanning the whole array after every append.
+ *
+ * Like other data objects, rings must otherwise only be modified from the
+ * main thread. To feed a ring from acquisition threads, enable its ingest
+ * queue with b_ring_vector_enable_ingest() or b_ring_matrix_enable_ingest().
+ * Any number of threads can then call b_ring_vector_ingest() or
+ * b_ring_matrix_ingest(), which copy the values into a preallocated queue
+ * without taking locks or allocating memory. The main loop drains the queue
+ * into the ring in one batch, at most once per frame, emitting a single
+ * "changed" signal.
  */
 
+/* Extrema over a sliding window, kept as a pair of monotonic deques. Each
+ * appended element (or row, for matrices) gets a sequence number; the deques
+ * hold the candidates for the minimum and maximum of the newest "window"
+ * elements, so both appending and querying are amortized O(1). Non-finite
+ * values are never added. Any change other than an append invalidates the
+ * deques, which are rebuilt on the next query. */
+
+typedef struct {
+  double *v;
+  guint32 *seq;
+  unsigned int cap, first, len;
+} RingExtremum;
+
+typedef struct {
+  RingExtremum lo, hi;
+  guint32 next; /* sequence number of the next element */
+  unsigned int window; /* number of elements in the ring */
+  gboolean valid;
+} RingMinMax;
+
+static RingMinMax *ring_minmax_new(unsigned int cap)
+{
+  RingMinMax *mm = g_new0(RingMinMax, 1);
+  mm->lo.v = g_new(double, cap);
+  mm->lo.seq = g_new(guint32, cap);
+  mm->lo.cap = cap;
+  mm->hi.v = g_new(double, cap);
+  mm->hi.seq = g_new(guint32, cap);
+  mm->hi.cap = cap;
+  return mm;
+}
+
+static void ring_minmax_free(RingMinMax *mm)
+{
+  g_free(mm->lo.v);
+  g_free(mm->lo.seq);
+  g_free(mm->hi.v);
+  g_free(mm->hi.seq);
+  g_free(mm);
+}
+
+static void ring_minmax_reset(RingMinMax *mm)
+{
+  mm->lo.first = mm->lo.len = 0;
+  mm->hi.first = mm->hi.len = 0;
+  mm->next = 0;
+  mm->window = 0;
+  mm->valid = TRUE;
+}
+
+/* drop candidates that have left the window */
+static void ring_extremum_expire(RingExtremum *q, guint32 oldest)
+{
+  while (q->len > 0 && (gint32)(q->seq[q->first] - oldest) < 0) {
+    q->first = (q->first + 1) % q->cap;
+    q->len--;
+  }
+}
+
+static void ring_extremum_push(RingExtremum *q, guint32 seq, double v, gboolean is_max)
+{
+  /* drop candidates that can no longer be the extremum */
+  while (q->len > 0) {
+    double b = q->v[(q->first + q->len - 1) % q->cap];
+    if (is_max ? (b > v) : (b < v))
+      break;
+    q->len--;
+  }
+  unsigned int k = (q->first + q->len) % q->cap;
+  q->v[k] = v;
+  q->seq[k] = seq;
+  q->len++;
+}
+
+/* add an element with finite extrema @lo and @hi (either may be non-finite
+ * if there are none); @window is the number of elements in the ring after the
+ * append */
+static void ring_minmax_push(RingMinMax *mm, double lo, double hi, unsigned int window)
+{
+  guint32 seq = mm->next++;
+  guint32 oldest = mm->next - window;
+  mm->window = window;
+  /* expire first, so that there is always room for the new candidate */
+  ring_extremum_expire(&mm->lo, oldest);
+  ring_extremum_expire(&mm->hi, oldest);
+  if (isfinite(lo))
+    ring_extremum_push(&mm->lo, seq, lo, FALSE);
+  if (isfinite(hi))
+    ring_extremum_push(&mm->hi, seq, hi, TRUE);
+}
+
+static void ring_minmax_get(RingMinMax *mm, double *min, double *max)
+{
+  RingExtremum *lo = &mm->lo, *hi = &mm->hi;
+  *min = lo->len > 0 ? lo->v[lo->first] : DBL_MAX;
+  *max = hi->len > 0 ? hi->v[hi->first] : -DBL_MAX;
+}
+
+/* Bounded multi-producer, single-consumer queue of fixed-size items.
+ *
+ * A producer reserves a run of items by advancing @reserve with a
+ * compare-and-exchange, copies its items in, then publishes each of them by
+ * setting the sequence number of its slot to its position plus one. No
+ * producer waits for another: the consumer (the main loop) reads the run of
+ * published items that starts at @read, and items published after a gap are
+ * read once the gap is filled. Counters are free-running and wrap around;
+ * @capacity is a power of two so that the wrapping is harmless, and a slot
+ * left from the previous lap has a sequence number @capacity too small. */
+
+/* drain at most this often, in microseconds: about once per frame */
+#define RING_INGEST_INTERVAL 16000
+
+typedef struct {
+  double *buf;
+  unsigned int capacity; /* in items */
+  unsigned int stride; /* doubles per item */
+  gint *seq; /* for each slot, the position of its item plus one */
+  gint reserve;
+  gint read;
+  GMainContext *context;
+  GSource *source;
+} RingIngest;
+
+typedef struct {
+  GSource base;
+  RingIngest *q;
+  gint64 last;
+  void (*drain) (gpointer ring);
+  gpointer ring;
+} RingIngestSource;
+
+static gboolean ring_ingest_is_published(RingIngest *q, guint pos)
+{
+  return (guint) g_atomic_int_get(&q->seq[pos & (q->capacity - 1)]) == pos + 1;
+}
+
+static gboolean ring_ingest_is_empty(RingIngest *q)
+{
+  return !ring_ingest_is_published(q, (guint) g_atomic_int_get(&q->read));
+}
+
+static gboolean ring_ingest_source_prepare(GSource *source, gint *timeout)
+{
+  RingIngestSource *is = (RingIngestSource *) source;
+  *timeout = -1;
+  if (ring_ingest_is_empty(is->q))
+    return FALSE;
+  gint64 wait = is->last + RING_INGEST_INTERVAL - g_source_get_time(source);
+  if (wait <= 0)
+    return TRUE;
+  *timeout = (gint) ((wait + 999) / 1000);
+  return FALSE;
+}
+
+static gboolean ring_ingest_source_check(GSource *source)
+{
+  RingIngestSource *is = (RingIngestSource *) source;
+  if (ring_ingest_is_empty(is->q))
+    return FALSE;
+  return g_source_get_time(source) >= is->last + RING_INGEST_INTERVAL;
+}
+
+static gboolean ring_ingest_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+  RingIngestSource *is = (RingIngestSource *) source;
+  is->last = g_source_get_time(source);
+  is->drain(is->ring);
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs ring_ingest_source_funcs = {
+  ring_ingest_source_prepare,
+  ring_ingest_source_check,
+  ring_ingest_source_dispatch,
+  NULL,
+};
+
+static RingIngest *ring_ingest_new(unsigned int capacity, unsigned int stride,
+                                   void (*drain) (gpointer ring), gpointer ring)
+{
+  RingIngest *q = g_new0(RingIngest, 1);
+  q->capacity = 1;
+  while (q->capacity < capacity)
+    q->capacity <<= 1;
+  q->stride = stride;
+  q->buf = g_new0(double, (gsize) q->capacity * stride);
+  q->seq = g_new0(gint, q->capacity);
+  q->context = g_main_context_ref_thread_default();
+
+  q->source = g_source_new(&ring_ingest_source_funcs, sizeof(RingIngestSource));
+  RingIngestSource *is = (RingIngestSource *) q->source;
+  is->q = q;
+  is->drain = drain;
+  is->ring = ring;
+  g_source_set_name(q->source, "BRing ingest");
+  g_source_attach(q->source, q->context);
+  return q;
+}
+
+static void ring_ingest_free(RingIngest *q)
+{
+  g_source_destroy(q->source);
+  g_source_unref(q->source);
+  g_main_context_unref(q->context);
+  g_free(q->buf);
+  g_free(q->seq);
+  g_free(q);
+}
+
+/* copy @n items in, each of @len doubles (the rest of each item is zeroed);
+ * returns FALSE if there is not enough room */
+static gboolean ring_ingest_push(RingIngest *q, const double *items, unsigned int n, unsigned int len)
+{
+  guint r;
+
+  if (n == 0)
+    return TRUE;
+  do {
+    r = (guint) g_atomic_int_get(&q->reserve);
+    guint rd = (guint) g_atomic_int_get(&q->read);
+    if (r + n - rd > q->capacity)
+      return FALSE;
+  } while (!g_atomic_int_compare_and_exchange(&q->reserve, (gint) r, (gint) (r + n)));
+
+  unsigned int k;
+  for (k = 0; k < n; k++) {
+    double *slot = &q->buf[(gsize) ((r + k) & (q->capacity - 1)) * q->stride];
+    memcpy(slot, &items[(gsize) k * len], len * sizeof(double));
+    if (len < q->stride)
+      memset(&slot[len], 0, (q->stride - len) * sizeof(double));
+    g_atomic_int_set(&q->seq[(r + k) & (q->capacity - 1)], (gint) (r + k + 1));
+  }
+
+  /* Wake the consumer if it is waiting for these items. If it has not
+     reached them yet, it will see them as published when it does, since
+     it advances @read before looking at the next slot. */
+  if (r == (guint) g_atomic_int_get(&q->read))
+    g_main_context_wakeup(q->context);
+  return TRUE;
+}
+
+/* get up to two spans of published items; call ring_ingest_release() after
+ * consuming them */
+static unsigned int ring_ingest_peek(RingIngest *q, const double **first,
+                                     unsigned int *n_first, const double **second,
+                                     unsigned int *n_second)
+{
+  guint rd = (guint) q->read;
+  unsigned int n = 0;
+  while (n < q->capacity && ring_ingest_is_published(q, rd + n))
+    n++;
+  unsigned int start = rd & (q->capacity - 1);
+  *n_first = MIN(n, q->capacity - start);
+  *n_second = n - *n_first;
+  *first = &q->buf[(gsize) start * q->stride];
+  *second = q->buf;
+  return n;
+}
+
+static void ring_ingest_release(RingIngest *q, unsigned int n)
+{
+  g_atomic_int_set(&q->read, (gint) ((guint) q->read + n));
+}
+
 /**
  * BRingVector:
  *
  * A BVector that grows up to a maximum length @nmax.
+ *
+ * Elements are stored in a circular buffer starting at @head, so appending is
+ * O(1) even when the ring is full. A contiguous copy is only made when
+ * b_vector_get_values() is called while the contents wrap around the end of
+ * the buffer.
  **/
 
 struct _BRingVector {
 	BVector base;
 	unsigned n;
 	unsigned int nmax;
+	unsigned int head; /* index in val of the oldest element */
 	double *val;
+	double *linear; /* contiguous copy, allocated on demand */
+	RingMinMax *minmax; /* allocated on first query */
 	BScalar *source;
 	gulong handler;
 	BRingVector *timestamps;
+	gboolean timestamps_updating;
+	RingIngest *ingest;
 };
 
 G_DEFINE_TYPE(BRingVector, b_ring_vector, B_TYPE_VECTOR);
 
+/* Timestamps are added while an update of the timestamp ring is held open,
+ * which is closed when the owner emits "changed". That way a block of
+ * appends results in one "changed" signal for the timestamps, emitted just
+ * before the one for the owner. */
+static void ring_stamp(BRingVector *ts, gboolean *updating, unsigned int count);
+static void ring_vector_emit_appended(BRingVector *d, unsigned int old_n, unsigned int len);
+static void ring_stamp_release(BRingVector *ts, gboolean *updating);
+
 static void b_ring_vector_finalize(GObject * obj)
 {
 	BRingVector *vec = (BRingVector *) obj;
 	if (vec->val)
 		g_free(vec->val);
+	g_clear_pointer(&vec->linear, g_free);
+	g_clear_pointer(&vec->minmax, ring_minmax_free);
 	if (vec->source) {
 		g_object_unref(vec->source);
 		g_signal_handler_disconnect(vec->source, vec->handler);
 	}
+	g_clear_pointer(&vec->ingest, ring_ingest_free);
+	ring_stamp_release(vec->timestamps, &vec->timestamps_updating);
+	g_clear_object(&vec->timestamps);
 
 	GObjectClass *obj_class = G_OBJECT_CLASS(b_ring_vector_parent_class);
 
 	(*obj_class->finalize) (obj);
 }
 
+/* copy the contents of the ring, oldest first, into a contiguous array */
+static void ring_vector_copy_out(BRingVector const *d, double *dest)
+{
+	unsigned int n_first = MIN(d->n, d->nmax - d->head);
+	memcpy(dest, &d->val[d->head], n_first * sizeof(double));
+	memcpy(&dest[n_first], d->val, (d->n - n_first) * sizeof(double));
+}
+
+/* rearrange storage so that the oldest element is at the start of val */
+static void ring_vector_linearize(BRingVector *d)
+{
+	if (d->head == 0)
+		return;
+	double *newval = g_new0(double, d->nmax);
+	ring_vector_copy_out(d, newval);
+	g_free(d->val);
+	d->val = newval;
+	d->head = 0;
+}
+
+/* add values to the storage, overwriting the oldest ones when full; does not
+ * emit "changed" */
+static void ring_vector_push(BRingVector *d, const double *arr, unsigned int len)
+{
+	if (len >= d->nmax) {
+		memcpy(d->val, &arr[len - d->nmax], d->nmax * sizeof(double));
+		d->head = 0;
+		d->n = d->nmax;
+		if (d->minmax)
+			d->minmax->valid = FALSE;
+		return;
+	}
+	if (d->minmax && d->minmax->valid) {
+		unsigned int k;
+		for (k = 0; k < len; k++)
+			ring_minmax_push(d->minmax, arr[k], arr[k],
+					 MIN(d->n + k + 1, d->nmax));
+	}
+	unsigned int tail = (d->head + d->n) % d->nmax;
+	unsigned int n_first = MIN(len, d->nmax - tail);
+	memcpy(&d->val[tail], arr, n_first * sizeof(double));
+	memcpy(d->val, &arr[n_first], (len - n_first) * sizeof(double));
+	if (d->n + len > d->nmax) {
+		d->head = (d->head + d->n + len - d->nmax) % d->nmax;
+		d->n = d->nmax;
+	}
+	else {
+		d->n += len;
+	}
+}
+
 static BData *b_ring_vector_dup(BData * src)
 {
 	BRingVector *dst = g_object_new(G_OBJECT_TYPE(src), NULL);
 	BRingVector const *src_val = (BRingVector const *)src;
 	dst->val = g_new0(double, src_val->nmax);
-	memcpy(dst->val, src_val->val, src_val->n * sizeof(double));
+	ring_vector_copy_out(src_val, dst->val);
 	dst->n = src_val->n;
+	dst->nmax = src_val->nmax;
 	return B_DATA(dst);
 }
 
@@ -92,9 +445,16 @@ static unsigned int b_ring_vector_load_len(BVector * vec)
 
 static double *b_ring_vector_load_values(BVector * vec)
 {
-	BRingVector const *val = (BRingVector const *)vec;
+	BRingVector *val = (BRingVector *)vec;
+
+	if (val->head + val->n <= val->nmax)
+		return &val->val[val->head];
 
-	return val->val;
+	/* contents wrap around, so make a contiguous copy */
+	if (val->linear == NULL)
+		val->linear = g_new(double, val->nmax);
+	ring_vector_copy_out(val, val->linear);
+	return val->linear;
 }
 
 static double b_ring_vector_get_value(BVector * vec, unsigned i)
@@ -102,17 +462,45 @@ static double b_ring_vector_get_value(BVector * vec, unsigned i)
 	BRingVector const *val = (BRingVector const *)vec;
 	g_return_val_if_fail(val != NULL && val->val != NULL
 			     && i < val->n, NAN);
-	return val->val[i];
+	return val->val[(val->head + i) % val->nmax];
+}
+
+static void b_ring_vector_load_minmax(BVector * vec, double *min, double *max)
+{
+	BRingVector *d = (BRingVector *)vec;
+
+	if (d->minmax == NULL)
+		d->minmax = ring_minmax_new(d->nmax);
+	if (!d->minmax->valid) {
+		unsigned int i;
+		ring_minmax_reset(d->minmax);
+		for (i = 0; i < d->n; i++) {
+			double v = d->val[(d->head + i) % d->nmax];
+			ring_minmax_push(d->minmax, v, v, i + 1);
+		}
+	}
+	ring_minmax_get(d->minmax, min, max);
+}
+
+static void b_ring_vector_emit_changed(BData * data)
+{
+	BRingVector *d = (BRingVector *)data;
+
+	B_DATA_CLASS(b_ring_vector_parent_class)->emit_changed(data);
+	ring_stamp_release(d->timestamps, &d->timestamps_updating);
 }
 
 static double *
 b_ring_vector_replace_cache(BVector *vec, unsigned len)
 {
-	BRingVector const *r = (BRingVector const *)vec;
+	BRingVector *r = (BRingVector *)vec;
 
 	if(len!=r->n) {
 		g_warning("Trying to replace cache in BRingVector.");
 	}
+	ring_vector_linearize(r);
+	if (r->minmax)
+		r->minmax->valid = FALSE;
 	return r->val;
 }
 
@@ -124,10 +512,12 @@ static void b_ring_vector_class_init(BRingVectorClass * val_klass)
 
 	gobject_klass->finalize = b_ring_vector_finalize;
 	BData_klass->dup = b_ring_vector_dup;
+	BData_klass->emit_changed = b_ring_vector_emit_changed;
 	vector_klass->load_len = b_ring_vector_load_len;
 	vector_klass->load_values = b_ring_vector_load_values;
 	vector_klass->get_value = b_ring_vector_get_value;
 	vector_klass->replace_cache = b_ring_vector_replace_cache;
+	vector_klass->load_minmax = b_ring_vector_load_minmax;
 }
 
 static void b_ring_vector_init(BRingVector * val)
@@ -170,23 +560,10 @@ BData *b_ring_vector_new(unsigned nmax, unsigned n, gboolean track_timestamps)
 void b_ring_vector_append(BRingVector * d, double val)
 {
   g_return_if_fail(B_IS_RING_VECTOR(d));
-  unsigned int l = d->n;
-  double *frames = d->val;
-  if (l < d->nmax) {
-    frames[l] = val;
-    b_ring_vector_set_length(d, l + 1);
-  }
-  else if (l == d->nmax) { /* need to move data over by one to fit new value */
-    memmove(frames, &frames[1], (l - 1) * sizeof(double));
-    frames[l - 1] = val;
-  }
-  else {
-    g_return_if_reached();
-  }
-  if(d->timestamps) {
-    b_ring_vector_append(d->timestamps,((double)g_get_real_time())/1e6);
-  }
-  b_data_emit_changed(B_DATA(d));
+  unsigned int old_n = d->n;
+  ring_vector_push(d, &val, 1);
+  ring_stamp(d->timestamps, &d->timestamps_updating, 1);
+  ring_vector_emit_appended(d, old_n, 1);
 }
 
 /**
@@ -202,36 +579,116 @@ void b_ring_vector_append_array(BRingVector * d, const double *arr, unsigned int
 {
   g_return_if_fail(B_IS_RING_VECTOR(d));
   g_return_if_fail(arr);
-  g_return_if_fail(len>=0);
-  unsigned int l = d->n;
-  double *frames = d->val;
-  unsigned int i;
-  double now = ((double)g_get_real_time())/1e6;
-  if (l + len <= d->nmax) {
-    for (i = 0; i < len; i++) {
-      frames[i + l] = arr[i];
-      if(d->timestamps) {
-        b_ring_vector_append(d->timestamps,now);
-      }
-    }
-    b_ring_vector_set_length(d, l + len);
-  }
-  else { /* need to make room for new values */
-    unsigned int offset;
-    if(len>d->nmax) {
-      //g_warning("Appending %u values to YRingVector with maximum length %u.",len,d->nmax);
-      offset = d->n;
-      memmove(frames, &frames[offset], offset*sizeof(double));
-      memcpy(frames,&arr[len-d->nmax],d->nmax*sizeof(double));
-    }
-    else {
-      offset = len - d->nmax + d->n;
-      memmove(frames, &frames[offset], (d->nmax-offset)*sizeof(double));
-      memcpy(&frames[d->nmax-len],arr,len*sizeof(double));
-    }
-    b_ring_vector_set_length(d, d->nmax);
+  unsigned int old_n = d->n;
+  ring_vector_push(d, arr, len);
+  ring_stamp(d->timestamps, &d->timestamps_updating, MIN(len, d->nmax));
+  ring_vector_emit_appended(d, old_n, len);
+}
+
+/* report the last @len values as appended, and the old values that were
+ * overwritten as dropped */
+static void ring_vector_emit_appended(BRingVector *d, unsigned int old_n, unsigned int len)
+{
+  unsigned int kept = MIN(len, d->n);
+  b_data_emit_appended(B_DATA(d), d->n - kept, d->n, old_n + kept - d->n);
+}
+
+static void ring_stamp(BRingVector *ts, gboolean *updating, unsigned int count)
+{
+  if (ts == NULL || count == 0)
+    return;
+  if (!*updating) {
+    b_data_begin_update(B_DATA(ts));
+    *updating = TRUE;
   }
-  b_data_emit_changed(B_DATA(d));
+  double now = ((double)g_get_real_time())/1e6;
+  unsigned int i, old_n = ts->n;
+  for (i = 0; i < count; i++)
+    ring_vector_push(ts, &now, 1);
+  ring_vector_emit_appended(ts, old_n, count);
+}
+
+static void ring_stamp_release(BRingVector *ts, gboolean *updating)
+{
+  if (ts == NULL || !*updating)
+    return;
+  *updating = FALSE;
+  b_data_end_update(B_DATA(ts));
+}
+
+static void ring_vector_drain(gpointer ring)
+{
+  b_ring_vector_drain(B_RING_VECTOR(ring));
+}
+
+/**
+ * b_ring_vector_enable_ingest :
+ * @d: #BRingVector
+ * @capacity: number of values the queue can hold
+ *
+ * Create a queue through which other threads can append values to @d with
+ * b_ring_vector_ingest(). Queued values are appended to @d by the main loop
+ * of the thread-default main context, at most once per frame. The capacity
+ * is rounded up to a power of two. Call this from the main thread before any
+ * producer starts.
+ **/
+void b_ring_vector_enable_ingest(BRingVector * d, unsigned int capacity)
+{
+  g_return_if_fail(B_IS_RING_VECTOR(d));
+  g_return_if_fail(capacity > 0);
+  g_return_if_fail(d->ingest == NULL);
+  d->ingest = ring_ingest_new(capacity, 1, ring_vector_drain, d);
+}
+
+/**
+ * b_ring_vector_ingest :
+ * @d: #BRingVector
+ * @arr: (array length=len): array
+ * @len: array length
+ *
+ * Queue values to be appended to @d. This function can be called from any
+ * thread, and by several threads at once. It does not take locks or allocate
+ * memory. Either all of @arr is queued or, if the queue does not have room,
+ * none of it is.
+ *
+ * Returns: %TRUE if the values were queued
+ **/
+gboolean b_ring_vector_ingest(BRingVector * d, const double *arr, unsigned int len)
+{
+  g_return_val_if_fail(B_IS_RING_VECTOR(d), FALSE);
+  g_return_val_if_fail(d->ingest != NULL, FALSE);
+  g_return_val_if_fail(arr != NULL || len == 0, FALSE);
+  return ring_ingest_push(d->ingest, arr, len, 1);
+}
+
+/**
+ * b_ring_vector_drain :
+ * @d: #BRingVector
+ *
+ * Append all values waiting in the ingest queue of @d, emitting a single
+ * "changed" signal. This is done automatically by the main loop, but can be
+ * called directly, e.g. just before drawing. Must be called from the main
+ * thread.
+ *
+ * Returns: the number of values appended
+ **/
+unsigned int b_ring_vector_drain(BRingVector * d)
+{
+  g_return_val_if_fail(B_IS_RING_VECTOR(d), 0);
+  if (d->ingest == NULL)
+    return 0;
+  const double *first, *second;
+  unsigned int n_first, n_second;
+  unsigned int n = ring_ingest_peek(d->ingest, &first, &n_first, &second, &n_second);
+  if (n == 0)
+    return 0;
+  b_data_begin_update(B_DATA(d));
+  b_ring_vector_append_array(d, first, n_first);
+  if (n_second > 0)
+    b_ring_vector_append_array(d, second, n_second);
+  b_data_end_update(B_DATA(d));
+  ring_ingest_release(d->ingest, n);
+  return n;
 }
 
 static void on_source_changed(BData * data, gpointer user_data)
@@ -277,13 +734,17 @@ void b_ring_vector_set_length(BRingVector * d, unsigned int newlength)
 {
 	g_return_if_fail(B_IS_RING_VECTOR(d));
 	if (newlength <= d->nmax) {
+		unsigned int i;
+		for (i = d->n; i < newlength; i++)
+			d->val[(d->head + i) % d->nmax] = 0.0;
 		d->n = newlength;
+		if (d->minmax)
+			d->minmax->valid = FALSE;
 		b_data_emit_changed(B_DATA(d));
 		if(d->timestamps) {
 			b_ring_vector_set_length(d->timestamps,newlength);
 		}
 	}
-	/* TODO: set tailing elements to zero */
 }
 
 /**
@@ -298,21 +759,65 @@ void b_ring_vector_set_length(BRingVector * d, unsigned int newlength)
 void b_ring_vector_set_max_length(BRingVector * d, unsigned int newmax)
 {
   g_return_if_fail(B_IS_RING_VECTOR(d));
-  d->nmax = newmax;
+  g_return_if_fail(newmax > 0);
+  ring_vector_linearize(d);
   double *newval = g_new0(double, newmax);
-  if (d->n > d->nmax) {
-    unsigned int oo = d->n - d->nmax;
+  if (d->n > newmax) {
+    unsigned int oo = d->n - newmax;
     memcpy(newval, &d->val[oo], newmax * sizeof(double));
     d->n = newmax;
   }
   else {
     memcpy(newval, d->val, d->n * sizeof(double));
   }
+  d->nmax = newmax;
   g_free(d->val);
   d->val = newval;
+  g_clear_pointer(&d->linear, g_free);
+  g_clear_pointer(&d->minmax, ring_minmax_free);
+  if(d->timestamps) {
+    b_ring_vector_set_max_length(d->timestamps,newmax);
+  }
   b_data_emit_changed(B_DATA(d)); /* cache address has changed */
 }
 
+/**
+ * b_ring_vector_get_segments :
+ * @d: #BRingVector
+ * @first: (out)(nullable)(transfer none): return location for the older segment
+ * @n_first: (out)(nullable): return location for the length of @first
+ * @second: (out)(nullable)(transfer none): return location for the newer segment
+ * @n_second: (out)(nullable): return location for the length of @second
+ *
+ * Get the contents of the vector without copying. Once the ring is full, the
+ * contents generally wrap around the end of the internal buffer, so they are
+ * returned as two segments: the oldest elements in @first, followed by the
+ * newest elements in @second. If the contents are contiguous, @n_second is
+ * set to zero. The pointers are valid until the vector is next changed.
+ *
+ * This avoids the copy that b_vector_get_values() has to make when the
+ * contents wrap around.
+ *
+ * Returns: the total length of the vector
+ **/
+unsigned int
+b_ring_vector_get_segments(BRingVector *d, const double **first,
+                           unsigned int *n_first, const double **second,
+                           unsigned int *n_second)
+{
+  g_return_val_if_fail(B_IS_RING_VECTOR(d), 0);
+  unsigned int n1 = MIN(d->n, d->nmax - d->head);
+  if (first)
+    *first = &d->val[d->head];
+  if (n_first)
+    *n_first = n1;
+  if (second)
+    *second = d->val;
+  if (n_second)
+    *n_second = d->n - n1;
+  return d->n;
+}
+
 /**
  * b_ring_vector_get_timestamps :
  * @d: #BRingVector
@@ -334,16 +839,25 @@ BRingVector *b_ring_vector_get_timestamps(BRingVector *d)
  * BRingMatrix:
  *
  * A BMatrix that grows up to a maximum height @rmax.
+ *
+ * Rows are stored in a circular buffer starting at row @head, so appending a
+ * row does not move the others. Use b_ring_matrix_get_row_segments() or
+ * b_ring_matrix_get_row() to read rows without making a contiguous copy.
  **/
 
 struct _BRingMatrix {
 	BMatrix base;
 	unsigned nr, nc;
 	unsigned int rmax;
+	unsigned int head; /* index in val of the oldest row */
 	double *val;
+	double *linear; /* contiguous copy, allocated on demand */
+	RingMinMax *minmax; /* extrema of each row, allocated on first query */
 	BVector *source;
 	gulong handler;
 	BRingVector *timestamps;
+	gboolean timestamps_updating;
+	RingIngest *ingest;
 };
 
 G_DEFINE_TYPE(BRingMatrix, b_ring_matrix, B_TYPE_MATRIX);
@@ -352,24 +866,39 @@ static void ring_matrix_finalize(GObject * obj)
 {
   BRingMatrix *vec = (BRingMatrix *) obj;
   g_clear_pointer(&vec->val,g_free);
+  g_clear_pointer(&vec->linear,g_free);
+  g_clear_pointer(&vec->minmax,ring_minmax_free);
   if (vec->source) {
     g_signal_handler_disconnect(vec->source, vec->handler);
     g_object_unref(vec->source);
   }
+  g_clear_pointer(&vec->ingest, ring_ingest_free);
+  ring_stamp_release(vec->timestamps, &vec->timestamps_updating);
+  g_clear_object(&vec->timestamps);
 
   GObjectClass *obj_class = G_OBJECT_CLASS(b_ring_matrix_parent_class);
 
   (*obj_class->finalize) (obj);
 }
 
+/* copy the rows, oldest first, into a contiguous array */
+static void ring_matrix_copy_out(BRingMatrix const *d, double *dest)
+{
+  unsigned int r_first = MIN(d->nr, d->rmax - d->head);
+  memcpy(dest, &d->val[d->head * d->nc], r_first * d->nc * sizeof(double));
+  memcpy(&dest[r_first * d->nc], d->val,
+         (d->nr - r_first) * d->nc * sizeof(double));
+}
+
 static BData *ring_matrix_dup(BData * src)
 {
   BRingMatrix *dst = g_object_new(G_OBJECT_TYPE(src), NULL);
   BRingMatrix const *src_val = (BRingMatrix const *)src;
-  dst->val = g_new(double, src_val->nc*src_val->rmax);
-  memcpy(dst->val, src_val->val, src_val->nc*src_val->nr * sizeof(double));
+  dst->val = g_new0(double, src_val->nc*src_val->rmax);
+  ring_matrix_copy_out(src_val, dst->val);
   dst->nr = src_val->nr;
   dst->nc = src_val->nc;
+  dst->rmax = src_val->rmax;
   return B_DATA(dst);
 }
 
@@ -384,9 +913,16 @@ static BMatrixSize ring_matrix_load_size(BMatrix * mat)
 
 static double *ring_matrix_load_values(BMatrix * vec)
 {
-  BRingMatrix const *val = (BRingMatrix const *)vec;
+  BRingMatrix *val = (BRingMatrix *)vec;
+
+  if (val->head + val->nr <= val->rmax)
+    return &val->val[val->head * val->nc];
 
-  return val->val;
+  /* rows wrap around, so make a contiguous copy */
+  if (val->linear == NULL)
+    val->linear = g_new(double, val->rmax * val->nc);
+  ring_matrix_copy_out(val, val->linear);
+  return val->linear;
 }
 
 static double ring_matrix_get_value(BMatrix * vec, unsigned i, unsigned j)
@@ -394,17 +930,60 @@ static double ring_matrix_get_value(BMatrix * vec, unsigned i, unsigned j)
   BRingMatrix const *val = (BRingMatrix const *)vec;
   g_return_val_if_fail(val != NULL && val->val != NULL
                          && i < val->nr && j<val->nc, NAN);
-  return val->val[i * val->nc + j];
+  return val->val[((val->head + i) % val->rmax) * val->nc + j];
+}
+
+/* push the finite extrema of a row */
+static void ring_matrix_push_row_minmax(BRingMatrix *d, const double *row, unsigned int window)
+{
+  double lo, hi;
+  if (!_b_minmax_double(row, d->nc, &lo, &hi)) {
+    lo = INFINITY;
+    hi = -INFINITY;
+  }
+  ring_minmax_push(d->minmax, lo, hi, window);
+}
+
+static void ring_matrix_load_minmax(BMatrix * mat, double *min, double *max)
+{
+  BRingMatrix *d = (BRingMatrix *)mat;
+
+  if (d->minmax == NULL)
+    d->minmax = ring_minmax_new(d->rmax);
+  if (!d->minmax->valid) {
+    unsigned int i;
+    ring_minmax_reset(d->minmax);
+    for (i = 0; i < d->nr; i++)
+      ring_matrix_push_row_minmax(d, &d->val[((d->head + i) % d->rmax) * d->nc], i + 1);
+  }
+  ring_minmax_get(d->minmax, min, max);
+}
+
+static void ring_matrix_emit_changed(BData * data)
+{
+  BRingMatrix *d = (BRingMatrix *)data;
+
+  B_DATA_CLASS(b_ring_matrix_parent_class)->emit_changed(data);
+  ring_stamp_release(d->timestamps, &d->timestamps_updating);
 }
 
 static double *
 b_ring_matrix_replace_cache(BMatrix *mat, unsigned len)
 {
-  BRingMatrix const *r = (BRingMatrix const *)mat;
+  BRingMatrix *r = (BRingMatrix *)mat;
 
   if(len!=r->nr*r->nc) {
     g_warning("Trying to replace cache in BRingMatrix.");
   }
+  if (r->minmax)
+    r->minmax->valid = FALSE;
+  if (r->head != 0) {
+    double *a = g_new0(double, r->rmax * r->nc);
+    ring_matrix_copy_out(r, a);
+    g_free(r->val);
+    r->val = a;
+    r->head = 0;
+  }
   return r->val;
 }
 
@@ -416,10 +995,12 @@ static void b_ring_matrix_class_init(BRingMatrixClass * val_klass)
 
   gobject_klass->finalize = ring_matrix_finalize;
   BData_klass->dup = ring_matrix_dup;
+  BData_klass->emit_changed = ring_matrix_emit_changed;
   matrix_klass->load_size = ring_matrix_load_size;
   matrix_klass->load_values = ring_matrix_load_values;
   matrix_klass->get_value = ring_matrix_get_value;
   matrix_klass->replace_cache = b_ring_matrix_replace_cache;
+  matrix_klass->load_minmax = ring_matrix_load_minmax;
 }
 
 static void b_ring_matrix_init(BRingMatrix * val)
@@ -465,26 +1046,98 @@ void b_ring_matrix_append(BRingMatrix * d, const double *values, unsigned int le
   g_return_if_fail(B_IS_RING_MATRIX(d));
   g_return_if_fail(values);
   g_return_if_fail(len<=d->nc);
-  unsigned int l = MIN(d->rmax, b_matrix_get_rows(B_MATRIX(d)));
-  double *frames = d->val;
-  unsigned int k;
-  if (l < d->rmax) {
-    for(k=0;k<len;k++) {
-      frames[l*d->nc+k] = values[k];
-    }
-    b_ring_matrix_set_rows(d, l + 1);
+  double *row;
+  unsigned int old_nr = d->nr;
+  if (d->nr < d->rmax) {
+    row = &d->val[((d->head + d->nr) % d->rmax) * d->nc];
+    d->nr++;
   }
-  else if (l == d->rmax) {
-    memmove(frames, &frames[d->nc], (l - 1) * d->nc*sizeof(double));
-    for(k=0;k<len;k++) {
-      frames[(l-1)*d->nc+k] = values[k];
-    }
+  else { /* overwrite the oldest row */
+    row = &d->val[d->head * d->nc];
+    d->head = (d->head + 1) % d->rmax;
   }
-  else return;
-  if(d->timestamps) {
-    b_ring_vector_append(d->timestamps,((double)g_get_real_time())/1e6);
-  }
-  b_data_emit_changed(B_DATA(d));
+  memcpy(row, values, len * sizeof(double));
+  memset(&row[len], 0, (d->nc - len) * sizeof(double));
+  if (d->minmax && d->minmax->valid)
+    ring_matrix_push_row_minmax(d, row, d->nr);
+  ring_stamp(d->timestamps, &d->timestamps_updating, 1);
+  b_data_emit_appended(B_DATA(d), d->nr - 1, d->nr, old_nr + 1 - d->nr);
+}
+
+static void ring_matrix_drain(gpointer ring)
+{
+  b_ring_matrix_drain(B_RING_MATRIX(ring));
+}
+
+/**
+ * b_ring_matrix_enable_ingest :
+ * @d: #BRingMatrix
+ * @capacity: number of rows the queue can hold
+ *
+ * Create a queue through which other threads can append rows to @d with
+ * b_ring_matrix_ingest(). Queued rows are appended to @d by the main loop
+ * of the thread-default main context, at most once per frame. The capacity
+ * is rounded up to a power of two. Call this from the main thread before any
+ * producer starts. The number of columns must not change afterwards.
+ **/
+void b_ring_matrix_enable_ingest(BRingMatrix * d, unsigned int capacity)
+{
+  g_return_if_fail(B_IS_RING_MATRIX(d));
+  g_return_if_fail(capacity > 0);
+  g_return_if_fail(d->ingest == NULL);
+  d->ingest = ring_ingest_new(capacity, d->nc, ring_matrix_drain, d);
+}
+
+/**
+ * b_ring_matrix_ingest :
+ * @d: #BRingMatrix
+ * @values: (array length=len): array
+ * @len: array length
+ *
+ * Queue a row to be appended to @d. This function can be called from any
+ * thread, and by several threads at once. It does not take locks or allocate
+ * memory.
+ *
+ * Returns: %TRUE if the row was queued, %FALSE if the queue was full
+ **/
+gboolean b_ring_matrix_ingest(BRingMatrix * d, const double *values, unsigned int len)
+{
+  g_return_val_if_fail(B_IS_RING_MATRIX(d), FALSE);
+  g_return_val_if_fail(d->ingest != NULL, FALSE);
+  g_return_val_if_fail(values != NULL, FALSE);
+  g_return_val_if_fail(len <= d->ingest->stride, FALSE);
+  return ring_ingest_push(d->ingest, values, 1, len);
+}
+
+/**
+ * b_ring_matrix_drain :
+ * @d: #BRingMatrix
+ *
+ * Append all rows waiting in the ingest queue of @d, emitting a single
+ * "changed" signal. This is done automatically by the main loop, but can be
+ * called directly. Must be called from the main thread.
+ *
+ * Returns: the number of rows appended
+ **/
+unsigned int b_ring_matrix_drain(BRingMatrix * d)
+{
+  g_return_val_if_fail(B_IS_RING_MATRIX(d), 0);
+  if (d->ingest == NULL)
+    return 0;
+  const double *first, *second;
+  unsigned int n_first, n_second, k;
+  unsigned int n = ring_ingest_peek(d->ingest, &first, &n_first, &second, &n_second);
+  if (n == 0)
+    return 0;
+  unsigned int stride = d->ingest->stride;
+  b_data_begin_update(B_DATA(d));
+  for (k = 0; k < n_first; k++)
+    b_ring_matrix_append(d, &first[(gsize) k * stride], stride);
+  for (k = 0; k < n_second; k++)
+    b_ring_matrix_append(d, &second[(gsize) k * stride], stride);
+  b_data_end_update(B_DATA(d));
+  ring_ingest_release(d->ingest, n);
+  return n;
 }
 
 static void on_vector_source_changed(BData * data, gpointer user_data)
@@ -530,7 +1183,13 @@ void b_ring_matrix_set_rows(BRingMatrix * d, unsigned int r)
 {
   g_return_if_fail(B_IS_RING_MATRIX(d));
   if (r <= d->rmax) {
+    unsigned int i;
+    for (i = d->nr; i < r; i++)
+      memset(&d->val[((d->head + i) % d->rmax) * d->nc], 0,
+             d->nc * sizeof(double));
     d->nr = r;
+    if (d->minmax)
+      d->minmax->valid = FALSE;
     b_data_emit_changed(B_DATA(d));
     if(d->timestamps) {
       b_ring_vector_set_length(d->timestamps,r);
@@ -543,28 +1202,88 @@ void b_ring_matrix_set_rows(BRingMatrix * d, unsigned int r)
  * @d: #BRingMatrix
  * @rmax: new maximum number of rows
  *
- * Set the maximum height of the #BRingMatrix to a new value.
+ * Set the maximum height of the #BRingMatrix to a new value. If the current
+ * height is greater than the new maximum, the oldest rows are freed.
  **/
 
 void b_ring_matrix_set_max_rows(BRingMatrix *d, unsigned int rmax)
 {
   g_return_if_fail(B_IS_RING_MATRIX(d));
-  if (rmax<d->rmax) { /* don't bother shrinking the array */
-    d->rmax = rmax;
-    if(d->nr>d->rmax) {
-      d->nr=d->rmax;
-    }
+  g_return_if_fail(rmax > 0);
+  if (rmax == d->rmax)
+    return;
+  double *a = g_new0(double, MAX(rmax, d->rmax) * d->nc);
+  ring_matrix_copy_out(d, a);
+  if (d->nr > rmax) {
+    unsigned int oo = d->nr - rmax;
+    memmove(a, &a[oo * d->nc], rmax * d->nc * sizeof(double));
+    d->nr = rmax;
   }
-  else if (rmax>d->rmax) {
-    double *a = g_new0(double, rmax*d->nc);
-    memcpy(a,d->val,sizeof(double)*d->rmax*d->nc);
-    g_free(d->val);
-    d->val = a;
-    d->rmax = rmax;
+  g_free(d->val);
+  d->val = a;
+  d->head = 0;
+  d->rmax = rmax;
+  g_clear_pointer(&d->linear, g_free);
+  g_clear_pointer(&d->minmax, ring_minmax_free);
+  if(d->timestamps) {
+    b_ring_vector_set_max_length(d->timestamps, rmax);
   }
   b_data_emit_changed(B_DATA(d)); /* cache address has changed */
 }
 
+/**
+ * b_ring_matrix_get_row_segments :
+ * @d: #BRingMatrix
+ * @first: (out)(nullable)(transfer none): return location for the older block of rows
+ * @rows_first: (out)(nullable): return location for the number of rows in @first
+ * @second: (out)(nullable)(transfer none): return location for the newer block of rows
+ * @rows_second: (out)(nullable): return location for the number of rows in @second
+ *
+ * Get the rows of the matrix without copying. Once the ring is full, the
+ * rows generally wrap around the end of the internal buffer, so they are
+ * returned as two contiguous row-major blocks: the oldest rows in @first,
+ * followed by the newest rows in @second. If the rows are contiguous,
+ * @rows_second is set to zero. The pointers are valid until the matrix is
+ * next changed.
+ *
+ * Returns: the total number of rows
+ **/
+unsigned int
+b_ring_matrix_get_row_segments(BRingMatrix *d, const double **first,
+                               unsigned int *rows_first, const double **second,
+                               unsigned int *rows_second)
+{
+  g_return_val_if_fail(B_IS_RING_MATRIX(d), 0);
+  unsigned int r1 = MIN(d->nr, d->rmax - d->head);
+  if (first)
+    *first = &d->val[d->head * d->nc];
+  if (rows_first)
+    *rows_first = r1;
+  if (second)
+    *second = d->val;
+  if (rows_second)
+    *rows_second = d->nr - r1;
+  return d->nr;
+}
+
+/**
+ * b_ring_matrix_get_row :
+ * @d: #BRingMatrix
+ * @i: row index, where 0 is the oldest row
+ *
+ * Get a row of the matrix without copying. The pointer is valid until the
+ * matrix is next changed.
+ *
+ * Returns: (transfer none): the @i-th row, or %NULL
+ **/
+const double *
+b_ring_matrix_get_row(BRingMatrix *d, unsigned int i)
+{
+  g_return_val_if_fail(B_IS_RING_MATRIX(d), NULL);
+  g_return_val_if_fail(i < d->nr, NULL);
+  return &d->val[((d->head + i) % d->rmax) * d->nc];
+}
+
 /**
  * b_ring_matrix_get_timestamps :
  * @d: #BRingMatrix
@@ -35,9 +35,14 @@ void b_ring_vector_set_length(BRingVector *d, unsigned int newlength);
 void b_ring_vector_set_max_length(BRingVector * d, unsigned int newmax);
 void b_ring_vector_append(BRingVector *d, double val);
 void b_ring_vector_append_array(BRingVector *d, const double *arr, unsigned int len);
+unsigned int b_ring_vector_get_segments(BRingVector *d, const double **first, unsigned int *n_first, const double **second, unsigned int *n_second);
 
 void b_ring_vector_set_source(BRingVector *d, BScalar *source);
 
+void b_ring_vector_enable_ingest(BRingVector *d, unsigned int capacity);
+gboolean b_ring_vector_ingest(BRingVector *d, const double *arr, unsigned int len);
+unsigned int b_ring_vector_drain(BRingVector *d);
+
 BRingVector *b_ring_vector_get_timestamps(BRingVector *d);
 
 G_DECLARE_FINAL_TYPE(BRingMatrix,b_ring_matrix,B,RING_MATRIX,BMatrix)
@@ -49,6 +54,12 @@ void b_ring_matrix_set_rows(BRingMatrix *d, unsigned int r);
 void b_ring_matrix_set_max_rows(BRingMatrix *d, unsigned int rmax);
 void b_ring_matrix_append(BRingMatrix *d, const double *values, unsigned int len);
 void b_ring_matrix_set_source(BRingMatrix *d, BVector *source);
+unsigned int b_ring_matrix_get_row_segments(BRingMatrix *d, const double **first, unsigned int *rows_first, const double **second, unsigned int *rows_second);
+const double *b_ring_matrix_get_row(BRingMatrix *d, unsigned int i);
+
+void b_ring_matrix_enable_ingest(BRingMatrix *d, unsigned int capacity);
+gboolean b_ring_matrix_ingest(BRingMatrix *d, const double *values, unsigned int len);
+unsigned int b_ring_matrix_drain(BRingMatrix *d);
 
 BRingVector *b_ring_matrix_get_timestamps(BRingMatrix *d);
 
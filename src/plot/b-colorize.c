@@ -0,0 +1,298 @@
+/*
+ * b-colorize.c :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "b-colorize.h"
+#include "data/b-ring.h"
+#include <math.h>
+#include <string.h>
+
+/* Colorization of values already normalized to [0,1] by a view interval.
+ *
+ * A value t maps to color floor(255 t), clamped to [0,255], and NaN maps to
+ * B_COLORIZE_NAN. The vector kernels compute the indices of a block of values
+ * without branching: they clamp in floating point, where NaN is replaced by
+ * zero, and then select the NaN index with a mask. The colors are then copied
+ * from the table, three bytes per pixel. The kernel is picked once, at the
+ * first call, according to what the CPU supports. */
+
+#define BLOCK 256
+
+typedef void (*IndexFunc) (const double *t, guint32 *idx, gsize n);
+
+static void
+index_scalar (const double *t, guint32 *idx, gsize n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      double v = t[i] * 255.0;
+      v = v > 0.0 ? v : 0.0;
+      v = v < 255.0 ? v : 255.0;
+      idx[i] = isnan (t[i]) ? B_COLORIZE_NAN : (guint32) v;
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+
+static void
+index_sse2 (const double *t, guint32 *idx, gsize n)
+{
+  const __m128d zero = _mm_setzero_pd ();
+  const __m128d top = _mm_set1_pd (255.0);
+  const __m128i nan_idx = _mm_set1_epi32 (B_COLORIZE_NAN);
+  gsize i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      __m128d x0 = _mm_loadu_pd (&t[i]);
+      __m128d x1 = _mm_loadu_pd (&t[i + 2]);
+      /* max returns its second operand, zero, for NaN */
+      __m128d v0 = _mm_min_pd (_mm_max_pd (_mm_mul_pd (x0, top), zero), top);
+      __m128d v1 = _mm_min_pd (_mm_max_pd (_mm_mul_pd (x1, top), zero), top);
+      __m128i k = _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (v0),
+                                      _mm_cvttpd_epi32 (v1));
+      __m128i nan = _mm_castps_si128 (
+        _mm_shuffle_ps (_mm_castpd_ps (_mm_cmpunord_pd (x0, x0)),
+                        _mm_castpd_ps (_mm_cmpunord_pd (x1, x1)),
+                        _MM_SHUFFLE (2, 0, 2, 0)));
+      k = _mm_or_si128 (_mm_andnot_si128 (nan, k), _mm_and_si128 (nan, nan_idx));
+      _mm_storeu_si128 ((__m128i *) &idx[i], k);
+    }
+  index_scalar (&t[i], &idx[i], n - i);
+}
+
+__attribute__((target ("avx2")))
+static void
+index_avx2 (const double *t, guint32 *idx, gsize n)
+{
+  const __m256d zero = _mm256_setzero_pd ();
+  const __m256d top = _mm256_set1_pd (255.0);
+  const __m128i nan_idx = _mm_set1_epi32 (B_COLORIZE_NAN);
+  const __m256i even = _mm256_setr_epi32 (0, 2, 4, 6, 1, 3, 5, 7);
+  gsize i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    {
+      __m256d x0 = _mm256_loadu_pd (&t[i]);
+      __m256d x1 = _mm256_loadu_pd (&t[i + 4]);
+      __m256d v0 = _mm256_min_pd (_mm256_max_pd (_mm256_mul_pd (x0, top), zero), top);
+      __m256d v1 = _mm256_min_pd (_mm256_max_pd (_mm256_mul_pd (x1, top), zero), top);
+      __m128i k0 = _mm256_cvttpd_epi32 (v0);
+      __m128i k1 = _mm256_cvttpd_epi32 (v1);
+      /* narrow the 64-bit NaN masks to 32 bits per lane */
+      __m256i m0 = _mm256_castpd_si256 (_mm256_cmp_pd (x0, x0, _CMP_UNORD_Q));
+      __m256i m1 = _mm256_castpd_si256 (_mm256_cmp_pd (x1, x1, _CMP_UNORD_Q));
+      __m128i n0 = _mm256_castsi256_si128 (_mm256_permutevar8x32_epi32 (m0, even));
+      __m128i n1 = _mm256_castsi256_si128 (_mm256_permutevar8x32_epi32 (m1, even));
+      k0 = _mm_blendv_epi8 (k0, nan_idx, n0);
+      k1 = _mm_blendv_epi8 (k1, nan_idx, n1);
+      _mm_storeu_si128 ((__m128i *) &idx[i], k0);
+      _mm_storeu_si128 ((__m128i *) &idx[i + 4], k1);
+    }
+  index_sse2 (&t[i], &idx[i], n - i);
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+
+static void
+index_neon (const double *t, guint32 *idx, gsize n)
+{
+  const float64x2_t zero = vdupq_n_f64 (0.0);
+  const float64x2_t top = vdupq_n_f64 (255.0);
+  const uint32x4_t nan_idx = vdupq_n_u32 (B_COLORIZE_NAN);
+  gsize i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      float64x2_t x0 = vld1q_f64 (&t[i]);
+      float64x2_t x1 = vld1q_f64 (&t[i + 2]);
+      /* maxnm returns the number, zero, for NaN */
+      float64x2_t v0 = vminq_f64 (vmaxnmq_f64 (vmulq_f64 (x0, top), zero), top);
+      float64x2_t v1 = vminq_f64 (vmaxnmq_f64 (vmulq_f64 (x1, top), zero), top);
+      uint32x4_t k = vcombine_u32 (vmovn_u64 (vcvtq_u64_f64 (v0)),
+                                   vmovn_u64 (vcvtq_u64_f64 (v1)));
+      uint32x4_t ok = vcombine_u32 (vmovn_u64 (vceqq_f64 (x0, x0)),
+                                    vmovn_u64 (vceqq_f64 (x1, x1)));
+      vst1q_u32 (&idx[i], vbslq_u32 (ok, k, nan_idx));
+    }
+  index_scalar (&t[i], &idx[i], n - i);
+}
+#endif
+
+static IndexFunc
+choose_index (void)
+{
+#if defined(HAVE_X86_KERNELS)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    return index_avx2;
+  return index_sse2;
+#elif defined(HAVE_NEON_KERNELS)
+  return index_neon;
+#else
+  return index_scalar;
+#endif
+}
+
+/* Write the colors of the @n normalized values @t to @rgb, three bytes per
+ * pixel, using the first three bytes of each entry of @lut, which has
+ * B_COLORIZE_LUT_SIZE entries. */
+void
+_b_colorize_row (const double *t, guchar *rgb, gsize n, const guint32 *lut)
+{
+  static IndexFunc func = NULL;
+  IndexFunc f = g_atomic_pointer_get (&func);
+  guint32 idx[BLOCK];
+  gsize i, j;
+
+  if (G_UNLIKELY (f == NULL))
+    {
+      f = choose_index ();
+      g_atomic_pointer_set (&func, f);
+    }
+
+  for (i = 0; i < n; i += BLOCK)
+    {
+      gsize m = MIN (BLOCK, n - i);
+      f (&t[i], idx, m);
+      /* four bytes are stored per pixel, the fourth being overwritten by
+         the next pixel, except for the last one of the row */
+      gsize last = (i + m == n) ? m - 1 : m;
+      for (j = 0; j < last; j++)
+        memcpy (&rgb[3 * (i + j)], &lut[idx[j]], 4);
+      for (; j < m; j++)
+        memcpy (&rgb[3 * (i + j)], &lut[idx[j]], 3);
+    }
+}
+
+/* Get the rows of @mat, returning FALSE if its values aren't available. */
+gboolean
+_b_matrix_rows_init (BMatrixRows * rows, BMatrix * mat)
+{
+  BMatrixSize size = b_matrix_get_size (mat);
+
+  rows->nrow = size.rows;
+  rows->ncol = size.columns;
+  rows->block[0] = rows->block[1] = NULL;
+  rows->block_rows[0] = size.rows;
+  rows->block_rows[1] = 0;
+  rows->type = B_ELEMENT_TYPE_DOUBLE;
+  if (B_IS_RING_MATRIX (mat))
+    {
+      const double *b0, *b1;
+      b_ring_matrix_get_row_segments (B_RING_MATRIX (mat),
+                                      &b0, &rows->block_rows[0],
+                                      &b1, &rows->block_rows[1]);
+      rows->block[0] = b0;
+      rows->block[1] = b1;
+    }
+  else
+    rows->block[0] = b_matrix_get_native_values (mat, &rows->type);
+  rows->row_bytes = rows->ncol * b_element_type_get_size (rows->type);
+
+  return rows->block[0] != NULL;
+}
+
+/* Rows are split into more bands than there are threads, which are taken in
+ * turn by the pool threads and the caller, so that an uneven band doesn't
+ * hold everybody up. */
+
+typedef struct
+{
+  BRowsFunc func;
+  gpointer user_data;
+  guint n_rows, n_bands;
+  gint next_band;
+  gint pending;
+  GMutex lock;
+  GCond done;
+} ParallelRows;
+
+static void
+bands_run (ParallelRows * p)
+{
+  guint b;
+
+  while ((b = g_atomic_int_add (&p->next_band, 1)) < p->n_bands)
+    p->func ((guint64) p->n_rows * b / p->n_bands,
+             (guint64) p->n_rows * (b + 1) / p->n_bands, p->user_data);
+}
+
+static void
+bands_worker (gpointer data, gpointer user_data)
+{
+  ParallelRows *p = data;
+
+  bands_run (p);
+  g_mutex_lock (&p->lock);
+  if (--p->pending == 0)
+    g_cond_signal (&p->done);
+  g_mutex_unlock (&p->lock);
+}
+
+/* Call @func on bands of the rows from 0 to @n_rows, from several threads,
+ * and return when all are done. @func must only write to its own rows. */
+void
+_b_parallel_rows (guint n_rows, BRowsFunc func, gpointer user_data)
+{
+  static GThreadPool *pool = NULL;
+  guint n_threads = MIN (g_get_num_processors (), n_rows);
+  guint i;
+
+  if (n_threads <= 1)
+    {
+      func (0, n_rows, user_data);
+      return;
+    }
+
+  if (g_once_init_enter (&pool))
+    g_once_init_leave (&pool, g_thread_pool_new (bands_worker, NULL,
+                                                 g_get_num_processors () - 1,
+                                                 FALSE, NULL));
+
+  ParallelRows p;
+  p.func = func;
+  p.user_data = user_data;
+  p.n_rows = n_rows;
+  p.n_bands = MIN (4 * n_threads, n_rows);
+  p.next_band = 0;
+  p.pending = n_threads - 1;
+  g_mutex_init (&p.lock);
+  g_cond_init (&p.done);
+
+  for (i = 0; i < n_threads - 1; i++)
+    g_thread_pool_push (pool, &p, NULL);
+  bands_run (&p);
+
+  g_mutex_lock (&p.lock);
+  while (p.pending > 0)
+    g_cond_wait (&p.done, &p.lock);
+  g_mutex_unlock (&p.lock);
+
+  g_mutex_clear (&p.lock);
+  g_cond_clear (&p.done);
+}
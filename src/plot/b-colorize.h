@@ -0,0 +1,67 @@
+/*
+ * b-colorize.h :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#pragma once
+
+/* Not installed: the colorization kernel used by the density view. */
+
+#include <glib.h>
+#include "data/b-data-class.h"
+
+G_BEGIN_DECLS
+
+/* 256 colors, followed by the color used for NaN */
+#define B_COLORIZE_LUT_SIZE 257
+#define B_COLORIZE_NAN 256
+
+typedef void (*BRowsFunc) (guint start, guint end, gpointer user_data);
+
+/* The rows of a matrix, read in place from up to two contiguous blocks, so
+ * that ring matrices don't have to be copied into a contiguous array, and in
+ * their native element type. Only valid until the matrix changes. */
+typedef struct
+{
+  gconstpointer block[2];
+  guint block_rows[2];
+  BElementType type;
+  gsize row_bytes;
+  guint nrow, ncol;
+} BMatrixRows;
+
+static inline gconstpointer
+_b_matrix_rows_get (const BMatrixRows * rows, guint i)
+{
+  return (i < rows->block_rows[0])
+    ? (const guchar *) rows->block[0] + i * rows->row_bytes
+    : (const guchar *) rows->block[1] + (i - rows->block_rows[0]) * rows->row_bytes;
+}
+
+G_GNUC_INTERNAL
+gboolean _b_matrix_rows_init (BMatrixRows *rows, BMatrix *mat);
+
+G_GNUC_INTERNAL
+void _b_colorize_row (const double *t, guchar *rgb, gsize n,
+                      const guint32 *lut);
+
+G_GNUC_INTERNAL
+void _b_parallel_rows (guint n_rows, BRowsFunc func, gpointer user_data);
+
+G_END_DECLS
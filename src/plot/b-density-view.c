@@ -21,7 +21,11 @@
 
 #include "plot/b-density-view.h"
 #include "plot/b-color-map.h"
+#include "plot/b-colorize.h"
+#include "plot/b-tile-pyramid.h"
+#include "data/b-ring.h"
 #include <math.h>
+#include <string.h>
 
 /* TODO */
 /*
@@ -37,6 +41,18 @@ Allow autoscaling symmetrically or asymetrically
  * Displays a color image showing the value of a matrix as a function of its
  * two axes.
  *
+ * Matrices with more than 4096x4096 elements are drawn in tiles, taken from
+ * a pyramid of reduced copies of the matrix, each element of which is the
+ * mean of 2x2 elements of the one below. Only the tiles in view are
+ * colorized, at the resolution of the screen, and the memory they use is
+ * limited by #BDensityView:tile-cache-size.
+ *
+ * A #BRingMatrix, such as a spectrogram, can be drawn as a waterfall by
+ * setting #BDensityView:waterfall. The image is then kept in blocks of rows,
+ * and each new row of the matrix is colorized once, into the newest block,
+ * while the older blocks are only moved. If the matrix was created with
+ * timestamps, the vertical axis shows the time each row was added.
+ *
  * To get the horizontal axis view interval and markers use axis type B_AXIS_TYPE_X,
  * and for the vertical axis use B_AXIS_TYPE_Y. The axis type to use to get the density
  * axis is B_AXIS_TYPE_Z.
@@ -59,15 +75,46 @@ enum
   DENSITY_VIEW_DOT_Y,
   DENSITY_VIEW_PRESERVE_ASPECT,
   DENSITY_VIEW_COLOR_MAP,
+  DENSITY_VIEW_TILE_CACHE_SIZE,
+  DENSITY_VIEW_WATERFALL,
   N_PROPERTIES
 };
 
+/* how the colorized matrix is kept, see redraw_surface() */
+typedef enum
+{
+  IMAGE_NONE,
+  IMAGE_TEXTURE,
+  IMAGE_TILES,
+  IMAGE_WATERFALL
+} ImageMode;
+
 static GObjectClass *parent_class;
 
 struct _BDensityView {
   BElementViewCartesian parent;
 
-  GdkPixbuf *pixbuf, *scaled_pixbuf;
+  ImageMode image_mode;
+
+  /* the colorized matrix, one pixel per element */
+  GdkTexture *texture;
+  GBytes *pixels;
+
+  /* used instead of the texture for large matrices */
+  BTilePyramid *tiles;
+  guint tile_cache_size;
+
+  /* used instead of the texture for ring matrices in waterfall mode, see
+     update_waterfall() */
+  gboolean waterfall;
+  GQueue waterfall_blocks;
+  guint64 waterfall_rows;
+
+  /* what the texture was colorized from, see redraw_surface() */
+  gboolean colors_valid;
+  guint64 color_gen;
+  double color_range[2];
+  int color_scale;
 
   BColorMap *map;
   gulong map_changed_id;
@@ -85,7 +132,6 @@ struct _BDensityView {
 
   gboolean sym_z;
 
-  double scalex, scaley;
   float aspect_ratio;
   gboolean preserve_aspect;
 
@@ -95,8 +141,44 @@ struct _BDensityView {
 
   gboolean draw_dot;
   double dot_pos_x, dot_pos_y;
+
+  /* retained image layer, see density_view_snapshot() */
+  GskRenderNode *data_node;
+  gboolean data_node_valid;
+  double node_range[4];
+  double node_place[4];
+  int node_width, node_height;
 };
 
+/* Get the position of the first row and the spacing of the rows. In
+ * waterfall mode these come from the timestamps of the ring matrix, if it
+ * has them, so that the vertical axis is the time each row was appended. */
+static void
+row_placement (BDensityView * widget, double *ymin, double *dy)
+{
+  *ymin = widget->ymin;
+  *dy = widget->dy;
+
+  if (!widget->waterfall || !B_IS_RING_MATRIX (widget->tdata))
+    return;
+
+  BRingVector *ts = b_ring_matrix_get_timestamps (B_RING_MATRIX (widget->tdata));
+  if (ts == NULL)
+    return;
+
+  unsigned int n = b_vector_get_len (B_VECTOR (ts));
+  if (n < 2)
+    return;
+
+  double t0 = b_vector_get_value (B_VECTOR (ts), 0);
+  double t1 = b_vector_get_value (B_VECTOR (ts), n - 1);
+  if (t1 > t0)
+    {
+      *ymin = t0;
+      *dy = (t1 - t0) / (n - 1);
+    }
+}
+
 static gboolean
 preferred_range (BElementViewCartesian * cart, BAxisType ax, double *a,
 		 double *b)
@@ -114,8 +196,10 @@ preferred_range (BElementViewCartesian * cart, BAxisType ax, double *a,
       }
       else if (ax == B_AXIS_TYPE_Y)
       {
-        *a = widget->ymin;
-        *b = widget->ymin + size.rows * widget->dy;
+        double ymin, dy;
+        row_placement (widget, &ymin, &dy);
+        *a = ymin;
+        *b = ymin + size.rows * dy;
       }
       else if (ax == B_AXIS_TYPE_Z)
       {
@@ -221,151 +305,354 @@ get_preferred_width_for_height (GtkWidget * w, gint for_height,
 }
  * */
 
-/* called when data size changes */
+/* Colorization of the matrix into the texture. Rows are read in place, see
+ * BMatrixRows, so typed matrices aren't converted to double. Large matrices
+ * are split into bands of rows colorized in parallel.
+ *
+ * The texture is only recolored when the matrix, the Z range or the color
+ * map changed since it was made. When the matrix is all that changed, and
+ * its change is a range of rows or rows appended to it, only those rows are
+ * colorized and the others are copied from the previous texture, moved by
+ * the number of rows dropped from the beginning for a ring matrix. */
+
+#define COLORIZE_PARALLEL_PIXELS (1 << 18)
+
+/* matrices with more elements are drawn as tiles, see b-tile-pyramid.c */
+#define TILED_MIN_ELEMENTS (4096 * 4096)
+
+typedef struct
+{
+  BViewInterval *viz;
+  BMatrixRows rows;
+  gsize nrow, ncol;
+  guint first_row;
+  guchar *pixels;
+  gsize rowstride;
+  guint32 lut[B_COLORIZE_LUT_SIZE];
+} Colorize;
+
+/* colorize rows from @start to @end, counted from z->first_row; may run in a
+   pool thread */
+static void
+colorize_rows (guint start, guint end, gpointer user_data)
+{
+  Colorize *z = user_data;
+  double *data = g_new (double, z->ncol);
+  guint i;
+
+  for (i = z->first_row + start; i < z->first_row + end; i++)
+    {
+      b_view_interval_conv_bulk_typed (z->viz, _b_matrix_rows_get (&z->rows, i),
+                                       z->rows.type, data, z->ncol);
+      _b_colorize_row (data, z->pixels + (z->nrow - 1 - i) * z->rowstride,
+                       z->ncol, z->lut);
+    }
+
+  g_free (data);
+}
 
+/* Find which rows of the matrix need to be colorized, copying the others
+ * from the previous texture to @pixels. Rows are stored last row first. */
 static void
-b_density_view_update_surface (BDensityView * widget)
+reuse_rows (BDensityView * widget, Colorize * z, guint * first, guint * last)
 {
-  if(widget->tdata == NULL)
+  *first = 0;
+  *last = z->nrow;
+
+  if (widget->pixels == NULL
+      || gdk_texture_get_width (widget->texture) != (int) z->ncol
+      || g_bytes_get_size (widget->pixels) % z->rowstride != 0
+      || b_data_get_generation (B_DATA (widget->tdata)) != widget->color_gen + 1)
     return;
 
-  int width = 0;
-  int height = 0;
+  gsize old_size;
+  const guchar *old = g_bytes_get_data (widget->pixels, &old_size);
+  guint old_nrow = old_size / z->rowstride;
+  const BDataChange *ch = b_data_get_change (B_DATA (widget->tdata));
 
-  if (widget->pixbuf != NULL)
+  if (ch->type == B_DATA_CHANGE_RANGE && old_nrow == z->nrow
+      && ch->end <= z->nrow)
+    {
+      memcpy (z->pixels, old, old_size);
+      *first = ch->start;
+      *last = ch->end;
+    }
+  else if (ch->type == B_DATA_CHANGE_APPEND && ch->end == z->nrow
+           && ch->start + ch->n_dropped == old_nrow)
     {
-      g_object_get (widget->pixbuf, "height", &height, "width", &width, NULL);
+      /* the rows that were kept are the first ch->start of the old ones,
+         which were at the start of the old image */
+      memcpy (z->pixels + (z->nrow - ch->start) * z->rowstride, old,
+              ch->start * z->rowstride);
+      *first = ch->start;
     }
+}
 
-  BMatrixSize size = b_matrix_get_size (widget->tdata);
+/* In waterfall mode the image of a ring matrix is kept in blocks of
+ * WATERFALL_BLOCK_ROWS rows, oldest first, and the rows appended to the
+ * matrix are colorized into the newest block, whose texture is the only one
+ * remade. Rows are numbered in the order they were appended, and the blocks
+ * are placed according to how many rows came after them, so scrolling only
+ * moves the blocks; blocks that have scrolled out of the matrix are
+ * dropped. */
 
-  if (size.rows == height || size.columns == width)
-    return;
+#define WATERFALL_BLOCK_ROWS 64
+
+typedef struct
+{
+  guint64 first_row;
+  guint n_rows;
+  guchar *pixels;
+  GdkTexture *texture;
+} WaterfallBlock;
+
+static void
+waterfall_block_free (gpointer data)
+{
+  WaterfallBlock *b = data;
+
+  g_clear_object (&b->texture);
+  g_free (b->pixels);
+  g_free (b);
+}
+
+static void
+waterfall_clear (BDensityView * widget)
+{
+  g_queue_clear_full (&widget->waterfall_blocks, waterfall_block_free);
+  widget->waterfall_rows = 0;
+}
+
+/* free the images of the modes other than @keep */
+static void
+clear_images (BDensityView * widget, ImageMode keep)
+{
+  if (keep != IMAGE_TEXTURE)
+    {
+      g_clear_object (&widget->texture);
+      g_clear_pointer (&widget->pixels, g_bytes_unref);
+    }
+  if (keep != IMAGE_TILES)
+    g_clear_pointer (&widget->tiles, _b_tile_pyramid_free);
+  if (keep != IMAGE_WATERFALL)
+    waterfall_clear (widget);
+  widget->image_mode = keep;
+}
+
+typedef struct
+{
+  Colorize *z;
+  guchar **dest;
+} WaterfallRows;
+
+/* may run in a pool thread */
+static void
+waterfall_colorize_rows (guint start, guint end, gpointer user_data)
+{
+  WaterfallRows *w = user_data;
+  Colorize *z = w->z;
+  double *data = g_new (double, z->ncol);
+  guint i;
 
-  if (widget->pixbuf != NULL)
+  for (i = start; i < end; i++)
     {
-      g_clear_object (&widget->pixbuf);
+      b_view_interval_conv_bulk_typed (z->viz,
+                                       _b_matrix_rows_get (&z->rows, z->first_row + i),
+                                       z->rows.type, data, z->ncol);
+      _b_colorize_row (data, w->dest[i], z->ncol, z->lut);
     }
 
-  widget->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, size.columns,
-                                   size.rows);
+  g_free (data);
 }
 
 static void
-b_density_view_rescale (BDensityView * widget)
+update_waterfall (BDensityView * widget, Colorize * z, gboolean same_colors)
 {
-  int width, height;
-  width = gtk_widget_get_allocated_width (GTK_WIDGET (widget));
-  height = gtk_widget_get_allocated_height (GTK_WIDGET (widget));
+  WaterfallBlock *b = g_queue_peek_tail (&widget->waterfall_blocks);
+  guint first = 0, i;
 
-  BMatrixSize size = b_matrix_get_size (widget->tdata);
+  /* only appended rows are colorized, the others are already in the blocks */
+  if (widget->image_mode == IMAGE_WATERFALL && same_colors && b != NULL
+      && b_data_get_generation (B_DATA (widget->tdata)) == widget->color_gen + 1
+      && gdk_texture_get_width (b->texture) == (int) z->ncol)
+    {
+      const BDataChange *ch = b_data_get_change (B_DATA (widget->tdata));
+      if (ch->type == B_DATA_CHANGE_APPEND && ch->end == z->nrow)
+        first = ch->start;
+    }
+  if (first == 0)
+    {
+      waterfall_clear (widget);
+      b = NULL;
+    }
+  clear_images (widget, IMAGE_WATERFALL);
 
-  size_t nrow = size.rows;
-  size_t ncol = size.columns;
+  /* find where the new rows go */
+  guint n_new = z->nrow - first;
+  WaterfallRows w = { z, g_new (guchar *, n_new) };
+  WaterfallBlock *oldest_touched = NULL;
+  for (i = 0; i < n_new; i++)
+    {
+      if (b == NULL || b->n_rows == WATERFALL_BLOCK_ROWS)
+        {
+          b = g_new0 (WaterfallBlock, 1);
+          b->first_row = widget->waterfall_rows;
+          b->pixels = g_malloc (z->rowstride * WATERFALL_BLOCK_ROWS);
+          g_queue_push_tail (&widget->waterfall_blocks, b);
+        }
+      if (oldest_touched == NULL)
+        oldest_touched = b;
+      w.dest[i] = b->pixels + b->n_rows * z->rowstride;
+      b->n_rows++;
+      widget->waterfall_rows++;
+    }
 
-  widget->scalex = ((double) width) / ncol;
-  widget->scaley = ((double) height) / nrow;
+  z->first_row = first;
+  if ((gsize) n_new * z->ncol >= COLORIZE_PARALLEL_PIXELS)
+    _b_parallel_rows (n_new, waterfall_colorize_rows, &w);
+  else
+    waterfall_colorize_rows (0, n_new, &w);
+  g_free (w.dest);
 
-  double aspect = (widget->scalex / widget->scaley);
-  if (fabs (aspect - 1.0) < 1e-2)
+  /* remake the textures of the blocks that got rows */
+  GList *l = g_queue_find (&widget->waterfall_blocks, oldest_touched);
+  for (; l != NULL; l = l->next)
     {
-      if (widget->scaley < widget->scalex)
-        widget->scalex = widget->scaley;
-      else
-        widget->scaley = widget->scalex;
+      b = l->data;
+      GBytes *bytes = g_bytes_new (b->pixels, b->n_rows * z->rowstride);
+      g_clear_object (&b->texture);
+      b->texture = gdk_memory_texture_new (z->ncol, b->n_rows,
+                                           GDK_MEMORY_R8G8B8, bytes,
+                                           z->rowstride);
+      g_bytes_unref (bytes);
     }
+
+  /* drop the blocks whose rows have all left the ring */
+  while ((b = g_queue_peek_head (&widget->waterfall_blocks)) != NULL
+         && b->first_row + b->n_rows <= widget->waterfall_rows - z->nrow)
+    waterfall_block_free (g_queue_pop_head (&widget->waterfall_blocks));
+}
+
+/* colorize the rows that changed into a new texture */
+static void
+update_texture (BDensityView * widget, Colorize * z, gboolean same_colors)
+{
+  clear_images (widget, IMAGE_TEXTURE);
+
+  /* textures are immutable, so each update fills a new buffer, which the
+     texture then owns */
+  z->pixels = g_malloc (z->rowstride * z->nrow);
+
+  guint first = 0, last = z->nrow;
+  if (same_colors)
+    reuse_rows (widget, z, &first, &last);
+
+  z->first_row = first;
+  if ((gsize) (last - first) * z->ncol >= COLORIZE_PARALLEL_PIXELS)
+    _b_parallel_rows (last - first, colorize_rows, z);
+  else
+    colorize_rows (0, last - first, z);
+
+  g_clear_pointer (&widget->pixels, g_bytes_unref);
+  widget->pixels = g_bytes_new_take (z->pixels, z->rowstride * z->nrow);
+  g_clear_object (&widget->texture);
+  widget->texture = gdk_memory_texture_new (z->ncol, z->nrow,
+                                            GDK_MEMORY_R8G8B8,
+                                            widget->pixels, z->rowstride);
 }
 
-/* redraw unscaled pixbuf */
+/* tiles are colorized when they come into view, so this only tells the
+   pyramid what changed */
+static void
+update_tiles (BDensityView * widget, Colorize * z, gboolean same_colors,
+              guint64 gen)
+{
+  gboolean created = widget->tiles == NULL;
+
+  clear_images (widget, IMAGE_TILES);
+  if (created)
+    widget->tiles = _b_tile_pyramid_new ((gsize) widget->tile_cache_size << 20);
+  if (created || !widget->colors_valid || gen != widget->color_gen)
+    _b_tile_pyramid_set_source (widget->tiles, &z->rows);
+  if (created || !same_colors)
+    _b_tile_pyramid_set_colors (widget->tiles, z->viz, z->lut);
+}
+
+/* update the texture to the matrix */
 static void
 redraw_surface(BDensityView *widget)
 {
-  int i, j;
+  int i;
 
   if(widget->tdata==NULL || widget->map==NULL)
     return;
 
-  const double *data = b_matrix_get_values (widget->tdata);
   BMatrixSize size = b_matrix_get_size (widget->tdata);
 
-  size_t nrow = size.rows;
-  size_t ncol = size.columns;
+  if (widget->preserve_aspect && size.rows > 0)
+    widget->aspect_ratio = ((float) size.columns / ((float) size.rows));
+  else
+    widget->aspect_ratio = -1;
 
-  double mn, mx;
-  BViewInterval *viz = b_element_view_cartesian_get_view_interval(B_ELEMENT_VIEW_CARTESIAN(widget),B_AXIS_TYPE_Z);
-  b_view_interval_range(viz,&mn,&mx);
+  if (size.rows == 0 || size.columns == 0)
+    {
+      clear_images (widget, IMAGE_NONE);
+      widget->data_node_valid = FALSE;
+      return;
+    }
 
-  int n_channels = gdk_pixbuf_get_n_channels (widget->pixbuf);
-  g_return_if_fail(n_channels != 4);
-  int rowstride = gdk_pixbuf_get_rowstride (widget->pixbuf);
-  guchar *pixels = gdk_pixbuf_get_pixels (widget->pixbuf);
+  Colorize z;
+  z.viz = b_element_view_cartesian_get_view_interval(B_ELEMENT_VIEW_CARTESIAN(widget),B_AXIS_TYPE_Z);
+  z.nrow = size.rows;
+  z.ncol = size.columns;
+  z.rowstride = (3 * z.ncol + 3) & ~(gsize) 3;
+
+  double zrange[2];
+  b_view_interval_range (z.viz, &zrange[0], &zrange[1]);
+  int zscale = b_view_interval_get_vi_type (z.viz);
+
+  gboolean same_colors = widget->colors_valid
+    && zrange[0] == widget->color_range[0]
+    && zrange[1] == widget->color_range[1]
+    && zscale == widget->color_scale;
+  ImageMode mode = IMAGE_TEXTURE;
+  if (widget->waterfall && B_IS_RING_MATRIX (widget->tdata))
+    mode = IMAGE_WATERFALL;
+  else if ((gsize) z.nrow * z.ncol >= TILED_MIN_ELEMENTS)
+    mode = IMAGE_TILES;
+  guint64 gen = b_data_get_generation (B_DATA (widget->tdata));
+
+  if (same_colors && gen == widget->color_gen && mode == widget->image_mode)
+    return;
 
-  unsigned char lut[256 * 4];
-  guint32 *mlut = (guint32 *) lut;
+  if (!_b_matrix_rows_init (&z.rows, widget->tdata))
+    return;
 
   double dl = 1.0 / 256.0;
   for (i = 0; i < 256; i++)
     {
-      mlut[i] = b_color_map_get_map(widget->map,i*dl);
-      //g_message("%d: %d %d %d %d",i,lut[4*i],lut[4*i+1],lut[4*i+2],lut[4*i+3]);
+      z.lut[i] = b_color_map_get_map(widget->map,i*dl);
     }
+  z.lut[B_COLORIZE_NAN] = 0;
 
-  for (i = 0; i < nrow; i++)
-    {
-      for (j = 0; j < ncol; j++)
-      {
-        if (isnan (data[i * ncol + j]))
-        {
-          pixels[n_channels * j + (nrow - 1 - i) * rowstride] = 0;
-          pixels[n_channels * j + (nrow - 1 - i) * rowstride + 1] = 0;
-          pixels[n_channels * j + (nrow - 1 - i) * rowstride + 2] = 0;
-        }
-        else
-        {
-          double ds = b_view_interval_conv(viz,data[i * ncol + j]);
-          if (ds <= 0.0) {
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride] =
-            lut[0];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 1] =
-            lut[1];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 2] =
-            lut[2];
-            /*pixels[n_channels * j + (nrow - 1 - i) * rowstride + 3] =
-            lut[3];*/
-          }
-          else if (ds>=1.0) {
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride] =
-            lut[4*255];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 1] =
-            lut[4*255+1];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 2] =
-            lut[4*255+1];
-            /*pixels[n_channels * j + (nrow - 1 - i) * rowstride + 3] =
-            lut[4*255+1];*/
-          }
-          else {
-            //g_message("%d %d %d, %d %d, %d",i,j,ss,nrow,ncol,rowstride);
-            /* should be able to do better than below */
-            int ss = (int) (ds * 255);
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride] =
-            lut[4 * ss];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 1] =
-            lut[4 * ss + 1];
-            pixels[n_channels * j + (nrow - 1 - i) * rowstride + 2] =
-            lut[4 * ss + 2];
-            /*pixels[n_channels * j + (nrow - 1 - i) * rowstride + 3] =
-            lut[4 * ss + 3];*/
-          }
-        }
-      }
-    }
+  if (mode == IMAGE_WATERFALL)
+    update_waterfall (widget, &z, same_colors);
+  else if (mode == IMAGE_TILES)
+    update_tiles (widget, &z, same_colors, gen);
+  else
+    update_texture (widget, &z, same_colors);
+
+  widget->colors_valid = TRUE;
+  widget->color_gen = gen;
+  widget->color_range[0] = zrange[0];
+  widget->color_range[1] = zrange[1];
+  widget->color_scale = zscale;
 
-    if (widget->preserve_aspect)
-      widget->aspect_ratio = ((float) size.columns / ((float) size.rows));
-    else
-      widget->aspect_ratio = -1;
+  widget->data_node_valid = FALSE;
 }
 
+/* the texture is updated by changed(), once the Z range has followed the
+   data */
 static void
 on_data_changed (BData * dat, gpointer user_data)
 {
@@ -377,9 +664,6 @@ on_data_changed (BData * dat, gpointer user_data)
   if (widget->tdata == NULL)
     return;
 
-  b_density_view_update_surface(widget);
-  redraw_surface(widget);
-
   gtk_widget_queue_resize (GTK_WIDGET (widget));
 
   b_element_view_changed (mev);
@@ -396,9 +680,7 @@ on_map_changed (BColorMap * map, gpointer user_data)
   if (widget->map == NULL)
     return;
 
-  redraw_surface(widget);
-
-  gtk_widget_queue_draw (GTK_WIDGET (widget));
+  widget->colors_valid = FALSE;
 
   b_element_view_changed (mev);
 }
@@ -581,7 +863,9 @@ density_view_motion_notify_event (GtkEventControllerMotion *controller, double x
 
       /* get index from coordinate */
       int i=(int)((x-dens_view->xmin)/dens_view->dx);
-      int j=(int)((y-dens_view->ymin)/dens_view->dy);
+      double ymin, dy;
+      row_placement (dens_view, &ymin, &dy);
+      int j=(int)((y-ymin)/dy);
       BMatrixSize size = b_matrix_get_size(dens_view->tdata);
       double z = NAN;
       if(i>=0 && j>=0 && i<size.columns && j<size.rows)
@@ -657,147 +941,217 @@ density_view_release_event (GtkGestureClick *gesture,
   return FALSE;
 }
 
+/* Find where the image goes in widget coordinates: its top left corner,
+ * which is the first column and the last row of the matrix, is at (@x0,@y0)
+ * and each of its pixels is @sx by @sy, which are negative when the image is
+ * flipped. */
 static gboolean
-density_view_draw (GtkWidget * w, cairo_t * cr)
+texture_placement (BDensityView * widget, double *x0, double *y0,
+                   double *sx, double *sy)
 {
-  BDensityView *widget = B_DENSITY_VIEW (w);
-  BElementViewCartesian *cart = B_ELEMENT_VIEW_CARTESIAN(w);
+  GtkWidget *w = GTK_WIDGET (widget);
+  BElementViewCartesian *cart = B_ELEMENT_VIEW_CARTESIAN (widget);
   BViewInterval *vix, *viy;
 
-  if (widget->pixbuf == NULL || widget->tdata == NULL)
-    {
-      return FALSE;
-    }
-
-  BMatrixSize size = b_matrix_get_size (widget->tdata);
-
-  size_t nrow = size.rows;
-  size_t ncol = size.columns;
+  if (widget->image_mode == IMAGE_NONE || widget->tdata == NULL)
+    return FALSE;
 
-  if (nrow == 0 || ncol == 0)
+  vix = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_X);
+  viy = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_Y);
+  if (vix == NULL || viy == NULL)
     return FALSE;
 
-  int used_width, used_height;
+  BMatrixSize size = b_matrix_get_size (widget->tdata);
+  int ncol = size.columns;
+  int nrow = size.rows;
 
-  used_width = ncol * widget->scalex;
-  used_height = nrow * widget->scaley;
+  double ymin, dy;
+  row_placement (widget, &ymin, &dy);
 
-  /*cairo_move_to(cr, 0,0);
-  cairo_line_to(cr,0,used_height);
-  cairo_line_to(cr,used_width,used_height);
-  cairo_line_to(cr,used_width,0);
-  cairo_line_to(cr,0,0);
-  cairo_stroke(cr);*/
+  BPoint c1, c2;
+  c1.x = b_view_interval_conv (vix, widget->xmin);
+  c1.y = b_view_interval_conv (viy, ymin + dy * nrow);
+  c2.x = b_view_interval_conv (vix, widget->xmin + widget->dx * ncol);
+  c2.y = b_view_interval_conv (viy, ymin);
+  _view_conv (w, &c1, &c1);
+  _view_conv (w, &c2, &c2);
 
-  int width, height;
+  *x0 = c1.x;
+  *y0 = c1.y;
+  *sx = (c2.x - c1.x) / ncol;
+  *sy = (c2.y - c1.y) / nrow;
 
-  width = gtk_widget_get_allocated_width (w);
-  height = gtk_widget_get_allocated_height (w);
+  return isfinite (*sx) && isfinite (*sy) && *sx != 0.0 && *sy != 0.0;
+}
 
-  /* calculate new scales based on how view intervals match our parameters */
-  double scalex = 1.0;
-  double scaley = 1.0;
-  double offsetx = 0.0;
-  double offsety = 0.0;
+/* Draw the tiles in view, at the level of detail of the screen, in the
+ * coordinates of the image, where the scale takes care of flips. */
+static void
+density_view_snapshot_tiles (BDensityView * widget, GtkSnapshot * s,
+                             const graphene_rect_t * bounds, double x0,
+                             double y0, double sx, double sy)
+{
+  double ix0 = (bounds->origin.x - x0) / sx;
+  double ix1 = (bounds->origin.x + bounds->size.width - x0) / sx;
+  double iy0 = (bounds->origin.y - y0) / sy;
+  double iy1 = (bounds->origin.y + bounds->size.height - y0) / sy;
+  graphene_rect_t visible = GRAPHENE_RECT_INIT (MIN (ix0, ix1), MIN (iy0, iy1),
+                                                fabs (ix1 - ix0),
+                                                fabs (iy1 - iy0));
+  guint level = _b_tile_pyramid_choose_level (widget->tiles,
+                                              1.0 / MAX (fabs (sx), fabs (sy)));
+  graphene_point_t origin = GRAPHENE_POINT_INIT (x0, y0);
+
+  gtk_snapshot_push_clip (s, bounds);
+  gtk_snapshot_save (s);
+  gtk_snapshot_translate (s, &origin);
+  gtk_snapshot_scale (s, sx, sy);
+  _b_tile_pyramid_snapshot (widget->tiles, s, &visible, level);
+  gtk_snapshot_restore (s);
+  gtk_snapshot_pop (s);
+}
 
-  vix = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_X);
+/* Draw the waterfall blocks, in the coordinates of the matrix, where y is the
+ * row index, so that the first row of each texture, the oldest, is at the
+ * bottom. Each block is placed according to the number of rows appended
+ * after it, which is what scrolls the image. */
+static void
+density_view_snapshot_waterfall (BDensityView * widget, GtkSnapshot * s,
+                                 const graphene_rect_t * bounds, double x0,
+                                 double y0, double sx, double sy)
+{
+  BMatrixSize size = b_matrix_get_size (widget->tdata);
+  guint64 oldest = widget->waterfall_rows - size.rows;
+  graphene_point_t origin = GRAPHENE_POINT_INIT (x0, y0);
+  graphene_point_t bottom = GRAPHENE_POINT_INIT (0, size.rows);
+  graphene_rect_t matrix = GRAPHENE_RECT_INIT (0, 0, size.columns, size.rows);
+  GList *l;
+
+  gtk_snapshot_push_clip (s, bounds);
+  gtk_snapshot_save (s);
+  gtk_snapshot_translate (s, &origin);
+  gtk_snapshot_scale (s, sx, sy);
+  gtk_snapshot_translate (s, &bottom);
+  gtk_snapshot_scale (s, 1, -1);
+  /* the oldest block is partly out of the matrix */
+  gtk_snapshot_push_clip (s, &matrix);
+  for (l = widget->waterfall_blocks.head; l != NULL; l = l->next)
+    {
+      WaterfallBlock *b = l->data;
+      graphene_rect_t r = GRAPHENE_RECT_INIT (0, (double) b->first_row - oldest,
+                                              size.columns, b->n_rows);
+      gtk_snapshot_append_scaled_texture (s, b->texture,
+                                          GSK_SCALING_FILTER_NEAREST, &r);
+    }
+  gtk_snapshot_pop (s);
+  gtk_snapshot_restore (s);
+  gtk_snapshot_pop (s);
+}
 
-  double wxmax = widget->xmin + widget->dx * ncol;
-  double wymax = widget->ymin + widget->dy * nrow; /* other end of interval */
+/* The texture is scaled by the renderer, without resampling on the CPU, and
+ * with nearest filtering so that the matrix elements stay sharp when zoomed
+ * in. Flips are done with a transform. */
+static void
+density_view_snapshot_data (GtkWidget * w, GtkSnapshot * s,
+                            const graphene_rect_t * bounds)
+{
+  BDensityView *widget = B_DENSITY_VIEW (w);
+  double x0, y0, sx, sy;
 
-  if (vix != NULL)
+  if (!texture_placement (widget, &x0, &y0, &sx, &sy))
+    return;
+
+  if (widget->image_mode == IMAGE_TILES)
     {
-      double t0, t1;
-      b_view_interval_range(vix,&t0,&t1);
-      double dx2 = (t1 - t0) / ncol;
-      double xmin = t0;
-
-      scalex = widget->scalex * widget->dx / dx2;
-      double wx0 = widget->xmin;
-      if(widget->dx<0) {
-        wx0 = wxmax;
-      }
-      offsetx = (wx0 - xmin) / widget->dx * scalex;
+      density_view_snapshot_tiles (widget, s, bounds, x0, y0, sx, sy);
+      return;
     }
-  viy = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_Y);
-
-  if (viy != NULL)
+  if (widget->image_mode == IMAGE_WATERFALL)
     {
-      double t0, t1;
-      b_view_interval_range(viy,&t0,&t1);
-      double dy2 = (t1 - t0) / nrow;
-      double ymax = t1;
-
-      scaley = widget->scaley * widget->dy / dy2;
-      double wy0 = wymax;
-      if(widget->dy<0) {
-        wy0 = widget->ymin;
-      }
-      offsety = -(wy0 - ymax) / widget->dy * scaley;
+      density_view_snapshot_waterfall (widget, s, bounds, x0, y0, sx, sy);
+      return;
     }
 
-  //g_message("scaley is %f, offsety is %f",scaley,offsety);
-
-  /* resize scaled pixbuf if necessary */
-
-  int pwidth = 0;
-  int pheight = 0;
-  if (widget->scaled_pixbuf != NULL)
-    g_object_get (widget->scaled_pixbuf, "height", &pheight, "width", &pwidth,
-                  NULL);
+  int ncol = gdk_texture_get_width (widget->texture);
+  int nrow = gdk_texture_get_height (widget->texture);
+  graphene_rect_t r = GRAPHENE_RECT_INIT (MIN (x0, x0 + sx * ncol),
+                                          MIN (y0, y0 + sy * nrow),
+                                          fabs (sx) * ncol,
+                                          fabs (sy) * nrow);
 
-  if (pheight != height || pwidth != width)
+  gtk_snapshot_push_clip (s, bounds);
+  gtk_snapshot_save (s);
+  if (sx < 0 || sy < 0)
     {
-      if (widget->scaled_pixbuf != NULL)
-        g_object_unref (widget->scaled_pixbuf);
-      widget->scaled_pixbuf =
-        gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+      graphene_point_t c = GRAPHENE_POINT_INIT (r.origin.x + r.size.width / 2,
+                                                r.origin.y + r.size.height / 2);
+      graphene_point_t mc = GRAPHENE_POINT_INIT (-c.x, -c.y);
+      gtk_snapshot_translate (s, &c);
+      gtk_snapshot_scale (s, sx < 0 ? -1 : 1, sy < 0 ? -1 : 1);
+      gtk_snapshot_translate (s, &mc);
     }
+  gtk_snapshot_append_scaled_texture (s, widget->texture,
+                                      GSK_SCALING_FILTER_NEAREST, &r);
+  gtk_snapshot_restore (s);
+  gtk_snapshot_pop (s);
+}
 
-  GdkPixbuf *buf = NULL;
-  if(scalex>=0 && scaley>=0) {
-    buf = g_object_ref(widget->pixbuf);
-  }
-  if(scalex<0 && scaley>=0) {
-    buf = gdk_pixbuf_flip(widget->pixbuf,TRUE);
-  }
-  if(scaley<0 && scalex>=0) {
-    buf = gdk_pixbuf_flip(widget->pixbuf,FALSE);
-  }
-  if(scalex<0 && scaley<0) {
-    GdkPixbuf *buf2 = gdk_pixbuf_flip(widget->pixbuf,FALSE);
-    buf = gdk_pixbuf_flip(buf2,TRUE);
-    g_object_unref(buf2);
-  }
-  g_return_val_if_fail(buf!=NULL,FALSE);
-
-  gdk_pixbuf_scale (buf, widget->scaled_pixbuf, 0, 0, used_width, used_height,
-                    offsetx, offsety, fabs(scalex), fabs(scaley), GDK_INTERP_TILES);
+/* cairo version of density_view_snapshot_data(), for drawing to a file, see
+ * b_plot_save() */
+static void
+density_view_draw_data (GtkWidget * w, cairo_t * cr)
+{
+  BDensityView *widget = B_DENSITY_VIEW (w);
+  double x0, y0, sx, sy;
 
-  g_object_unref(buf);
+  if (!texture_placement (widget, &x0, &y0, &sx, &sy))
+    return;
 
-  /* clip to size of matrix */
+  if (widget->image_mode != IMAGE_TEXTURE)
+    {
+      graphene_rect_t bounds =
+        GRAPHENE_RECT_INIT (0, 0, gtk_widget_get_allocated_width (w),
+                            gtk_widget_get_allocated_height (w));
+      GtkSnapshot *ds = gtk_snapshot_new ();
+      density_view_snapshot_data (w, ds, &bounds);
+      GskRenderNode *node = gtk_snapshot_free_to_node (ds);
+      if (node != NULL)
+        {
+          gsk_render_node_draw (node, cr);
+          gsk_render_node_unref (node);
+        }
+      return;
+    }
 
-  /* need to handle case when vix, viy are NULL? */
-  g_assert(vix);
-  g_assert(viy);
-  BPoint c1, c2;
-  c1.x = b_view_interval_conv(vix,widget->xmin);
-  c1.y = b_view_interval_conv(viy,widget->ymin);
-  c2.x = b_view_interval_conv(vix,wxmax);
-  c2.y = b_view_interval_conv(viy,wymax);
-  _view_conv (w, &c1, &c1);
-  _view_conv (w, &c2, &c2);
-  cairo_move_to(cr,c1.x,c1.y);
-  cairo_line_to(cr,c1.x,c2.y);
-  cairo_line_to(cr,c2.x,c2.y);
-  cairo_line_to(cr,c2.x,c1.y);
-  cairo_line_to(cr,c1.x,c1.y);
-  cairo_clip(cr);
+  int ncol = gdk_texture_get_width (widget->texture);
+  int nrow = gdk_texture_get_height (widget->texture);
+  cairo_surface_t *image =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32, ncol, nrow);
+  gdk_texture_download (widget->texture, cairo_image_surface_get_data (image),
+                        cairo_image_surface_get_stride (image));
+  cairo_surface_mark_dirty (image);
+
+  cairo_save (cr);
+  cairo_translate (cr, x0, y0);
+  cairo_scale (cr, sx, sy);
+  cairo_set_source_surface (cr, image, 0, 0);
+  cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_NEAREST);
+  cairo_rectangle (cr, 0, 0, ncol, nrow);
+  cairo_fill (cr);
+  cairo_restore (cr);
+
+  cairo_surface_destroy (image);
+}
 
-  gdk_cairo_set_source_pixbuf (cr, widget->scaled_pixbuf, 0, 0);
+static void
+density_view_draw_overlay (GtkWidget * w, cairo_t * cr)
+{
+  BDensityView *widget = B_DENSITY_VIEW (w);
+  BElementViewCartesian *cart = B_ELEMENT_VIEW_CARTESIAN(w);
+  BViewInterval *vix, *viy;
 
-  cairo_paint (cr);
+  vix = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_X);
+  viy = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_Y);
 
   if (widget->draw_line)
     {
@@ -897,39 +1251,73 @@ density_view_draw (GtkWidget * w, cairo_t * cr)
 
       cairo_fill (cr);
     }
+}
 
-  return FALSE;
+/* The image is kept as a render node and only rebuilt when the matrix, the
+ * color map, the view intervals or the allocation change. */
+
+static gboolean
+data_layer_is_current (BDensityView * widget)
+{
+  BElementViewCartesian *cart = B_ELEMENT_VIEW_CARTESIAN (widget);
+  BViewInterval *vix, *viy;
+  double range[4] = { 0, 0, 0, 0 };
+
+  vix = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_X);
+  viy = b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_Y);
+  if (vix != NULL)
+    b_view_interval_range (vix, &range[0], &range[1]);
+  if (viy != NULL)
+    b_view_interval_range (viy, &range[2], &range[3]);
+
+  int width = gtk_widget_get_allocated_width (GTK_WIDGET (widget));
+  int height = gtk_widget_get_allocated_height (GTK_WIDGET (widget));
+
+  /* the placement of the image is only applied when drawing */
+  double place[4] = { widget->xmin, widget->dx, widget->ymin, widget->dy };
+
+  gboolean current = widget->data_node != NULL && widget->data_node_valid
+    && width == widget->node_width && height == widget->node_height
+    && memcmp (range, widget->node_range, sizeof (range)) == 0
+    && memcmp (place, widget->node_place, sizeof (place)) == 0;
+
+  memcpy (widget->node_range, range, sizeof (range));
+  memcpy (widget->node_place, place, sizeof (place));
+  widget->node_width = width;
+  widget->node_height = height;
+
+  return current;
 }
 
 static void
 density_view_snapshot (GtkWidget   *w,
                       GtkSnapshot *s)
 {
+  BDensityView *widget = B_DENSITY_VIEW (w);
   graphene_rect_t bounds;
   if (gtk_widget_compute_bounds(w,w,&bounds)) {
+    if (!data_layer_is_current (widget)) {
+      GtkSnapshot *ds = gtk_snapshot_new ();
+      density_view_snapshot_data (w, ds, &bounds);
+      g_clear_pointer (&widget->data_node, gsk_render_node_unref);
+      widget->data_node = gtk_snapshot_free_to_node (ds);
+      widget->data_node_valid = TRUE;
+    }
+    if (widget->data_node != NULL)
+      gtk_snapshot_append_node (s, widget->data_node);
+
     cairo_t *cr = gtk_snapshot_append_cairo (s, &bounds);
-    density_view_draw(w, cr);
+    density_view_draw_overlay (w, cr);
+    cairo_destroy (cr);
   }
 }
 
-static void
-b_density_view_resize (GtkDrawingArea *area,
-               int             width,
-               int             height)
+/* draw the view with cairo, for b_plot_save(), which is not ported yet */
+G_GNUC_UNUSED static void
+density_view_draw (GtkWidget * w, cairo_t * cr)
 {
-  BDensityView *widget = B_DENSITY_VIEW (area);
-
-  if (width < 1 || height < 1)
-    return;
-
-  if (widget->tdata == NULL)
-    return;
-
-  /* set scale from new widget size */
-
-  b_density_view_rescale (widget);
-
-  return;
+  density_view_draw_data (w, cr);
+  density_view_draw_overlay (w, cr);
 }
 
 static void
@@ -972,8 +1360,8 @@ b_density_view_finalize (GObject * obj)
     }
 
   g_clear_object(&self->map);
-  g_clear_object(&self->pixbuf);
-  g_clear_object(&self->scaled_pixbuf);
+  clear_images (self, IMAGE_NONE);
+  g_clear_pointer(&self->data_node, gsk_render_node_unref);
 
   if (parent_class->finalize)
     parent_class->finalize (obj);
@@ -984,6 +1372,7 @@ b_density_view_set_property (GObject * object, guint property_id,
 			     const GValue * value, GParamSpec * pspec)
 {
   BDensityView *self = (BDensityView *) object;
+  gboolean overlay_only = FALSE;
 
   switch (property_id)
     {
@@ -996,9 +1385,9 @@ b_density_view_set_property (GObject * object, guint property_id,
         }
         //disconnect old data, if present
         self->tdata = g_value_dup_object (value);
+        self->colors_valid = FALSE;
         if (self->tdata)
         {
-          b_density_view_update_surface (self);
           /* connect to changed signal */
           self->tdata_changed_id =
           g_signal_connect_after (self->tdata, "changed",
@@ -1035,36 +1424,43 @@ b_density_view_set_property (GObject * object, guint property_id,
     case DENSITY_VIEW_DRAW_LINE:
       {
         self->draw_line = g_value_get_boolean (value);
+        overlay_only = TRUE;
       }
       break;
     case DENSITY_VIEW_LINE_DIR:
       {
         self->line_dir = g_value_get_int (value);
+        overlay_only = TRUE;
       }
       break;
     case DENSITY_VIEW_LINE_POS:
       {
         self->line_pos = g_value_get_double (value);
+        overlay_only = TRUE;
       }
       break;
     case DENSITY_VIEW_LINE_WIDTH:
       {
         self->line_width = g_value_get_double (value);
+        overlay_only = TRUE;
       }
       break;
     case DENSITY_VIEW_DRAW_DOT:
       {
         self->draw_dot = g_value_get_boolean (value);
+        overlay_only = TRUE;
       }
       break;
     case DENSITY_VIEW_DOT_X:
         {
           self->dot_pos_x = g_value_get_double (value);
+          overlay_only = TRUE;
         }
       break;
     case DENSITY_VIEW_DOT_Y:
         {
           self->dot_pos_y = g_value_get_double (value);
+          overlay_only = TRUE;
         }
       break;
     case DENSITY_VIEW_PRESERVE_ASPECT:
@@ -1080,6 +1476,7 @@ b_density_view_set_property (GObject * object, guint property_id,
           g_object_unref (self->map);
         }
         self->map = g_value_dup_object (value);
+        self->colors_valid = FALSE;
         if (self->map)
         {
           /* connect to changed signal */
@@ -1089,12 +1486,30 @@ b_density_view_set_property (GObject * object, guint property_id,
         }
         break;
       }
+    case DENSITY_VIEW_TILE_CACHE_SIZE:
+      {
+        self->tile_cache_size = g_value_get_uint (value);
+        if (self->tiles)
+          _b_tile_pyramid_set_max_memory (self->tiles,
+                                          (gsize) self->tile_cache_size << 20);
+      }
+      break;
+    case DENSITY_VIEW_WATERFALL:
+      {
+        self->waterfall = g_value_get_boolean (value);
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
     }
-  b_element_view_changed(B_ELEMENT_VIEW(self));
+  /* the line cut and dot are drawn over the retained image, so they don't
+     need the matrix to be recolored */
+  if (overlay_only)
+    gtk_widget_queue_draw (GTK_WIDGET (self));
+  else
+    b_element_view_changed(B_ELEMENT_VIEW(self));
 }
 
 static void
@@ -1179,6 +1594,16 @@ b_density_view_get_property (GObject * object, guint property_id,
         g_value_set_object (value, self->map);
       }
       break;
+    case DENSITY_VIEW_TILE_CACHE_SIZE:
+      {
+        g_value_set_uint (value, self->tile_cache_size);
+      }
+      break;
+    case DENSITY_VIEW_WATERFALL:
+      {
+        g_value_set_boolean (value, self->waterfall);
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1340,8 +1765,21 @@ b_density_view_class_init (BDensityViewClass * klass)
                G_PARAM_READWRITE |
                G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, DENSITY_VIEW_TILE_CACHE_SIZE,
+           g_param_spec_uint ("tile-cache-size", "Tile cache size",
+               "Memory in MiB for the tiles of matrices with more than 4096x4096 elements, which are drawn in tiles at the resolution of the screen",
+               1, G_MAXUINT >> 20, 256,
+               G_PARAM_READWRITE |
+               G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, DENSITY_VIEW_WATERFALL,
+           g_param_spec_boolean ("waterfall", "Waterfall",
+               "Draw a ring matrix as a scrolling waterfall, with the times of its rows on the vertical axis",
+               FALSE,
+               G_PARAM_READWRITE |
+               G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
-  GtkDrawingAreaClass *drawing_area_class = GTK_DRAWING_AREA_CLASS (klass);
 
   BElementViewClass *view_class = B_ELEMENT_VIEW_CLASS (klass);
   BElementViewCartesianClass *cart_class =
@@ -1353,8 +1791,6 @@ b_density_view_class_init (BDensityViewClass * klass)
 
   cart_class->preferred_range = preferred_range;
 
-  drawing_area_class->resize = b_density_view_resize;
-
   widget_class->get_request_mode = get_request_mode;
   widget_class->snapshot = density_view_snapshot;
   widget_class->measure = density_view_measure;
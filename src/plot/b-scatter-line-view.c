@@ -50,13 +50,35 @@ enum
   PROP_H_CURSOR_POS,
   PROP_SHOW_CURSORS,
   PROP_CURSOR_COLOR,
-  PROP_CURSOR_WIDTH
+  PROP_CURSOR_WIDTH,
+  PROP_AUTOSCALE_VISIBLE_X,
+  PROP_THREADED,
+  PROP_PROGRESSIVE,
+  PROP_STRIP_CHART
 };
 
 struct _BScatterLineView
 {
   BElementViewCartesian base;
   GList *series;
+  GHashTable *cache;
+  GskRenderNode *data_node;
+  gboolean data_node_valid;
+  gboolean threaded;
+  gpointer frame;               /* RasterFrame in flight */
+  gboolean frame_valid;
+  gboolean progressive;
+  guint refine_id;
+  cairo_surface_t *refine_surface;
+  guint refine_series;
+  int refine_stage, refine_offset;
+  gboolean strip_chart;
+  cairo_surface_t *strip_surface;
+  double strip_x0, strip_x1;    /* X range at the edges of the raster */
+  double strip_y0, strip_y1;
+  int strip_ytype;
+  double strip_offset;          /* logical pixels the raster lags the view */
+  int strip_width, strip_height, strip_scale;
   BPoint op_start;
   BPoint cursor_pos;
   double v_cursor;
@@ -64,6 +86,7 @@ struct _BScatterLineView
   GdkRGBA cursor_color;
   double cursor_width;
   gboolean show_cursors;
+  gboolean autoscale_visible_x;
   gboolean zoom_in_progress;
   gboolean pan_in_progress;
   gboolean v_cursor_move_in_progress;
@@ -74,6 +97,8 @@ struct _BScatterLineView
 G_DEFINE_TYPE (BScatterLineView, b_scatter_line_view,
 	       B_TYPE_ELEMENT_VIEW_CARTESIAN);
 
+static void raster_frame_drop (gpointer data);
+
 static void
 handlers_disconnect_and_clear (gpointer data, gpointer user_data)
 {
@@ -116,6 +141,12 @@ b_scatter_line_view_finalize (GObject * obj)
   BScatterLineView *v = B_SCATTER_LINE_VIEW (obj);
   g_list_foreach (v->series, handlers_disconnect_and_clear, v);
   g_list_free (v->series);
+  g_clear_pointer (&v->cache, g_hash_table_destroy);
+  g_clear_pointer (&v->data_node, gsk_render_node_unref);
+  g_clear_pointer (&v->frame, raster_frame_drop);
+  g_clear_handle_id (&v->refine_id, g_source_remove);
+  g_clear_pointer (&v->refine_surface, cairo_surface_destroy);
+  g_clear_pointer (&v->strip_surface, cairo_surface_destroy);
 
   if (parent_class->finalize)
     parent_class->finalize (obj);
@@ -465,6 +496,25 @@ b_scatter_line_view_release_event (GtkGestureClick *gesture,
   return FALSE;
 }
 
+/* widen min and max by a small margin and put them in a and b */
+static void
+add_margins (BViewInterval * vi, double min, double max, double *a,
+             double *b)
+{
+  /* Add 5% in 'margins' */
+  double w = max - min;
+  if (w == 0)
+    w = (min != 0 ? min : 1.0);
+  if(!b_view_interval_is_logarithmic(vi))
+    min -= w * 0.025;
+  max += w * 0.025;
+
+  if (a)
+    *a = min;
+  if (b)
+    *b = max;
+}
+
 /* calculate the interval that just fits the data inside, with a little extra margin, and put it in a and b
 
 return TRUE ("valid") if:
@@ -477,7 +527,6 @@ valid_range (BViewInterval * vi, BVector * data, double *a, double *b)
   gint i, i0, i1;
   double min = 0.0;
   double max = 1.0;
-  double w;
   gboolean first_min = TRUE, first_max = TRUE;
 
   if (b_vector_get_len (data) == 0)
@@ -528,19 +577,100 @@ valid_range (BViewInterval * vi, BVector * data, double *a, double *b)
         return FALSE;
     }
 
-  /* Add 5% in 'margins' */
-  w = max - min;
-  if (w == 0)
-    w = (min != 0 ? min : 1.0);
-  if(!b_view_interval_is_logarithmic(vi))
-    min -= w * 0.025;
-  max += w * 0.025;
+  add_margins (vi, min, max, a, b);
 
-  if (a)
-    *a = min;
-  if (b)
-    *b = max;
+  return TRUE;
+}
+
+/* Find the indices [start, end) of the first n points whose X lies in the
+ * view interval. With no X vector the indices are the X values. Returns
+ * FALSE if X is not sorted. */
+static gboolean
+index_window (BViewInterval * vix, BVector * xdata, unsigned int n,
+              unsigned int *start, unsigned int *end)
+{
+  double x0, x1;
+
+  b_view_interval_range (vix, &x0, &x1);
+
+  if (xdata == NULL)
+    {
+      *start = (x0 > 0.0) ? (unsigned int) MIN (ceil (x0), (double) n) : 0;
+      *end = (x1 >= 0.0) ? (unsigned int) MIN (floor (x1) + 1.0, (double) n) : 0;
+      return TRUE;
+    }
+  if (!b_vector_find_range (xdata, x0, x1, start, end))
+    return FALSE;
+  *end = MIN (*end, n);
+  *start = MIN (*start, *end);
+  return TRUE;
+}
+
+/*
+Like valid_range() for @ydata, but only includes points whose X value is
+within the X view interval. If X is sorted (or absent), the points are found
+by bisection and the extrema come from the range index of @ydata, so this
+doesn't depend on the length of the data.
+*/
+static gboolean
+visible_range (BViewInterval * vix, BViewInterval * viy, BVector * xdata,
+               BVector * ydata, double *a, double *b)
+{
+  double x0, x1, min, max;
+  unsigned int i, start, end, n;
+
+  n = b_vector_get_len (ydata);
+  if (xdata != NULL)
+    n = MIN (n, b_vector_get_len (xdata));
+
+  if (!index_window (vix, xdata, n, &start, &end))
+    {
+      /* unsorted X: scan it */
+      b_view_interval_range (vix, &x0, &x1);
+      min = DBL_MAX;
+      max = -DBL_MAX;
+      for (i = 0; i < n; i++)
+        {
+          double x = b_vector_get_value (xdata, i);
+          double y = b_vector_get_value (ydata, i);
+          if (x >= x0 && x <= x1 && isfinite (y)
+              && b_view_interval_valid (viy, y))
+            {
+              min = MIN (min, y);
+              max = MAX (max, y);
+            }
+        }
+      if (min > max)
+        return FALSE;
+      add_margins (viy, min, max, a, b);
+      return TRUE;
+    }
+
+  if (start >= end)
+    return FALSE;
+
+  if (!b_vector_get_range_minmax (ydata, start, end, &min, &max))
+    return FALSE;
+
+  if (!(b_view_interval_valid (viy, min) && b_view_interval_valid (viy, max)))
+    {
+      /* e.g. values <= 0 on a log axis */
+      min = DBL_MAX;
+      max = -DBL_MAX;
+      for (i = start; i < end; i++)
+        {
+          double y = b_vector_get_value (ydata, i);
+          if (isfinite (y) && b_view_interval_valid (viy, y))
+            {
+              min = MIN (min, y);
+              max = MAX (max, y);
+            }
+        }
+      if (min > max)
+        return FALSE;
+    }
 
+  add_margins (viy, min, max, a, b);
   return TRUE;
 }
 
@@ -583,7 +713,13 @@ preferred_range (BElementViewCartesian * cart, BAxisType ax, double *a,
     if (seq)
       {
         double ai,bi;
-        gboolean vrp = valid_range (b_element_view_cartesian_get_view_interval (cart, ax),
+        gboolean vrp;
+        if (ax == B_AXIS_TYPE_Y && scat->autoscale_visible_x)
+          vrp = visible_range (b_element_view_cartesian_get_view_interval (cart, B_AXIS_TYPE_X),
+                               b_element_view_cartesian_get_view_interval (cart, ax),
+                               xdata, seq, &ai, &bi);
+        else
+          vrp = valid_range (b_element_view_cartesian_get_view_interval (cart, ax),
 		      seq, &ai, &bi);
         if(vrp) {
           if(isnan(*a) || *a>ai)
@@ -616,48 +752,485 @@ preferred_range (BElementViewCartesian * cart, BAxisType ax, double *a,
   return FALSE;
 }
 
-struct draw_struct
+/* M4 decimation: for each run of consecutive points that fall in the same
+ * pixel column, keep only the first, last, minimum and maximum point, in
+ * their original order. For monotonic X the resulting polyline covers
+ * exactly the same pixels as the full one. A NaN point ends a run and is
+ * kept (once) so that gaps in the line are preserved. @out may be @in. */
+
+typedef struct
 {
-  BScatterLineView *scat;
-  cairo_t *cr;
-};
+  BPoint first, lo, hi, last;
+  int i_first, i_lo, i_hi, i_last;
+  int count;
+  double col;
+} M4Column;
+
+static int
+m4_flush (BPoint * out, int n, const M4Column * c)
+{
+  if (c->count == 0)
+    return n;
+  out[n++] = c->first;
+  if (c->count == 1)
+    return n;
+
+  const BPoint *p1 = &c->lo, *p2 = &c->hi;
+  int i1 = c->i_lo, i2 = c->i_hi;
+  if (i1 > i2)
+    {
+      p1 = &c->hi;
+      p2 = &c->lo;
+      i1 = c->i_hi;
+      i2 = c->i_lo;
+    }
+  if (i1 != c->i_first && i1 != c->i_last)
+    out[n++] = *p1;
+  if (i2 != i1 && i2 != c->i_first && i2 != c->i_last)
+    out[n++] = *p2;
+  out[n++] = c->last;
+  return n;
+}
 
-static void
-series_draw (gpointer data, gpointer user_data)
+static int
+decimate_m4 (const BPoint * in, BPoint * out, int N, double scale)
 {
-  BScatterSeries *series = B_SCATTER_SERIES (data);
+  M4Column c;
+  int i, n = 0;
 
-  if(!b_scatter_series_get_show(series))
-    return;
-  struct draw_struct *s = user_data;
-  BScatterLineView *scat = s->scat;
-  cairo_t *cr = s->cr;
-  GtkWidget *w = GTK_WIDGET (scat);
+  c.count = 0;
+  for (i = 0; i < N; i++)
+    {
+      BPoint p = in[i];
+      if (isnan (p.x) || isnan (p.y))
+        {
+          n = m4_flush (out, n, &c);
+          c.count = 0;
+          if (n == 0 || !isnan (out[n - 1].x))
+            {
+              out[n].x = NAN;
+              out[n].y = NAN;
+              n++;
+            }
+          continue;
+        }
+      double col = floor (p.x * scale);
+      if (c.count > 0 && col == c.col)
+        {
+          if (p.y < c.lo.y)
+            {
+              c.lo = p;
+              c.i_lo = i;
+            }
+          if (p.y > c.hi.y)
+            {
+              c.hi = p;
+              c.i_hi = i;
+            }
+          c.last = p;
+          c.i_last = i;
+          c.count++;
+          continue;
+        }
+      n = m4_flush (out, n, &c);
+      c.first = c.lo = c.hi = c.last = p;
+      c.i_first = c.i_lo = c.i_hi = c.i_last = i;
+      c.count = 1;
+      c.col = col;
+    }
+  return m4_flush (out, n, &c);
+}
 
-  BVector *xdata, *ydata;
+static gboolean
+use_decimation (BDecimation decimation, BVector * xdata, int N,
+                BDashing dash, int width)
+{
+  if (decimation == B_DECIMATION_OFF)
+    return FALSE;
+  if (decimation == B_DECIMATION_ON)
+    return TRUE;
+
+  /* dashes would restart at every dropped vertex */
+  if (dash != B_DASHING_SOLID || N <= 4 * width)
+    return FALSE;
+
+  return xdata == NULL || b_vector_is_sorted (xdata);
+}
+
+/* Pixel coordinates of the points of a series and a copy of its style, kept
+ * between snapshots so that redraws for the cursors or zoom box don't have to
+ * convert the data again. The geometry is recomputed when anything in the
+ * key changes. */
+
+#define SPRITE_STEPS 4
+
+typedef struct
+{
+  gboolean draw_line;
+  double line_width;
+  GdkRGBA line_color;
+  BDashing dash;
+  BMarker marker;
+  GdkRGBA marker_color;
+  double marker_size;
+  BDecimation decimation;
+} SeriesStyle;
+
+typedef struct
+{
+  BVector *xdata, *ydata;       /* not owned, only compared */
   BData *xerr, *yerr;
-  g_object_get (series, "x-data", &xdata, "y-data", &ydata,
-                        "x-err", &xerr, "y-err", &yerr, NULL);
+  guint64 xgen, ygen, xerrgen, yerrgen;
+  double x0, x1, y0, y1;
+  int xtype, ytype;
+  int width, height, scale;
+} SeriesKey;
 
-  BViewInterval *vi_x, *vi_y;
-  int i, N;
+typedef struct
+{
+  gboolean style_valid;
+  SeriesStyle style;
+  gboolean valid;
+  SeriesKey key;
+  /* threaded rendering: what the last frame was started from; its geometry
+     is built in the pool and not kept here */
+  gboolean raster_valid;
+  SeriesKey raster_key;
+  unsigned int i0;              /* data index of pos[0] */
+  int n;
+  BPoint *pos;
+  cairo_path_t line_path;
+  cairo_surface_t *markers;     /* marker layer in device pixels */
+  cairo_surface_t *sprites[SPRITE_STEPS * SPRITE_STEPS];
+  int sprite_half, sprite_scale;
+  /* strip chart: changes to the X and Y data since the raster was drawn */
+  guint64 strip_gen[2];
+  guint strip_appended[2], strip_dropped[2];
+  gboolean strip_appends_only;
+  gboolean strip_sorted;
+} SeriesCache;
+
+/* Markers are stamped from small images rendered once per style, scale and
+ * quarter-pixel offset, and composited into a layer kept with the geometry.
+ * Vector targets (PDF, PostScript and SVG) get real paths instead. */
 
-#if PROFILE
-  GTimer *t = g_timer_new ();
-#endif
+static gboolean
+target_is_vector (cairo_t * cr)
+{
+  switch (cairo_surface_get_type (cairo_get_target (cr)))
+    {
+    case CAIRO_SURFACE_TYPE_PDF:
+    case CAIRO_SURFACE_TYPE_PS:
+    case CAIRO_SURFACE_TYPE_SVG:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
 
-  if (ydata == NULL)
+/* all markers of a series are drawn with one fill or stroke */
+static void
+draw_markers_path (cairo_t * cr, const SeriesStyle * st, const BPoint * pos,
+                   int n)
+{
+  void (*path) (cairo_t *, BPoint, double);
+  gboolean fill = FALSE;
+  int i;
+
+  switch (st->marker)
     {
+    case B_MARKER_CIRCLE:
+      fill = TRUE;
+      /* fall through */
+    case B_MARKER_OPEN_CIRCLE:
+      path = _path_marker_circle;
+      break;
+    case B_MARKER_SQUARE:
+      fill = TRUE;
+      /* fall through */
+    case B_MARKER_OPEN_SQUARE:
+      path = _path_marker_square;
+      break;
+    case B_MARKER_DIAMOND:
+      fill = TRUE;
+      /* fall through */
+    case B_MARKER_OPEN_DIAMOND:
+      path = _path_marker_diamond;
+      break;
+    case B_MARKER_X:
+      path = _path_marker_x;
+      break;
+    case B_MARKER_PLUS:
+      path = _path_marker_plus;
+      break;
+    default:
       return;
     }
 
-  vi_x =
-    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
-						B_AXIS_TYPE_X);
+  cairo_set_source_rgba (cr, st->marker_color.red, st->marker_color.green,
+                         st->marker_color.blue, st->marker_color.alpha);
 
-  vi_y =
-    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
-						B_AXIS_TYPE_Y);
+  for (i = 0; i < n; i++)
+    {
+      if(!isnan(pos[i].x) & !isnan(pos[i].y))
+        path (cr, pos[i], st->marker_size);
+    }
+  fill ? cairo_fill (cr) : cairo_stroke (cr);
+}
+
+static void
+marker_sprites_create (SeriesCache * c)
+{
+  const SeriesStyle *st = &c->style;
+  int scale = c->key.scale;
+  int k;
+
+  /* half-width in device pixels, including the stroke */
+  c->sprite_half = (int) ceil ((M_SQRT1_2 * st->marker_size + 2.0) * scale);
+  int size = 2 * c->sprite_half + 2;
+
+  for (k = 0; k < SPRITE_STEPS * SPRITE_STEPS; k++)
+    {
+      BPoint center;
+      cairo_surface_t *sprite =
+        cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
+      cairo_t *cr = cairo_create (sprite);
+      cairo_scale (cr, scale, scale);
+      center.x = (c->sprite_half + (double) (k % SPRITE_STEPS) / SPRITE_STEPS) / scale;
+      center.y = (c->sprite_half + (double) (k / SPRITE_STEPS) / SPRITE_STEPS) / scale;
+      draw_markers_path (cr, st, &center, 1);
+      cairo_destroy (cr);
+      cairo_surface_flush (sprite);
+      c->sprites[k] = sprite;
+    }
+  c->sprite_scale = scale;
+}
+
+static void
+marker_sprites_free (SeriesCache * c)
+{
+  int k;
+  for (k = 0; k < SPRITE_STEPS * SPRITE_STEPS; k++)
+    g_clear_pointer (&c->sprites[k], cairo_surface_destroy);
+}
+
+/* composite premultiplied ARGB32 @sprite over @dst at (@x0,@y0) */
+static void
+sprite_blit (guchar * dst, int dst_stride, int width, int height,
+             cairo_surface_t * sprite, int x0, int y0)
+{
+  const guchar *src = cairo_image_surface_get_data (sprite);
+  int src_stride = cairo_image_surface_get_stride (sprite);
+  int sw = cairo_image_surface_get_width (sprite);
+  int sh = cairo_image_surface_get_height (sprite);
+  int i0 = MAX (0, -x0), i1 = MIN (sw, width - x0);
+  int j0 = MAX (0, -y0), j1 = MIN (sh, height - y0);
+  int i, j;
+
+  for (j = j0; j < j1; j++)
+    {
+      const guint32 *s = (const guint32 *) (src + j * src_stride);
+      guint32 *d = (guint32 *) (dst + (y0 + j) * dst_stride) + x0;
+      for (i = i0; i < i1; i++)
+        {
+          guint32 sp = s[i];
+          guint32 a = sp >> 24;
+          if (a == 0)
+            continue;
+          if (a == 255)
+            {
+              d[i] = sp;
+              continue;
+            }
+          guint32 dp = d[i], out = 0;
+          int shift;
+          for (shift = 0; shift < 32; shift += 8)
+            {
+              guint32 dc = (dp >> shift) & 0xff;
+              guint32 sc = (sp >> shift) & 0xff;
+              out |= (sc + (dc * (255 - a) + 127) / 255) << shift;
+            }
+          d[i] = out;
+        }
+    }
+}
+
+/* stamp the markers at @pos into an image whose left edge is at device x
+ * @x0 */
+static void
+marker_layer_blit (cairo_surface_t * layer, int x0, const BPoint * pos,
+                   int n, cairo_surface_t * const *sprites, int half,
+                   int scale)
+{
+  int width = cairo_image_surface_get_width (layer);
+  int height = cairo_image_surface_get_height (layer);
+  int i;
+
+  cairo_surface_flush (layer);
+  guchar *data = cairo_image_surface_get_data (layer);
+  int stride = cairo_image_surface_get_stride (layer);
+
+  for (i = 0; i < n; i++)
+    {
+      const BPoint *p = &pos[i];
+      if (isnan (p->x) || isnan (p->y))
+        continue;
+      /* round to the nearest quarter pixel */
+      double qx = floor (p->x * scale * SPRITE_STEPS + 0.5);
+      double qy = floor (p->y * scale * SPRITE_STEPS + 0.5);
+      if (fabs (qx) > 4.0 * SPRITE_STEPS * (x0 + width)
+          || fabs (qy) > 4.0 * SPRITE_STEPS * height)
+        continue;
+      int ix = (int) floor (qx / SPRITE_STEPS), iy = (int) floor (qy / SPRITE_STEPS);
+      int k = ((int) qy - iy * SPRITE_STEPS) * SPRITE_STEPS + ((int) qx - ix * SPRITE_STEPS);
+      sprite_blit (data, stride, width, height, sprites[k],
+                   ix - half - x0, iy - half);
+    }
+  cairo_surface_mark_dirty (layer);
+}
+
+static void
+marker_sprites_ensure (SeriesCache * c)
+{
+  if (c->sprites[0] == NULL || c->sprite_scale != c->key.scale)
+    {
+      marker_sprites_free (c);
+      marker_sprites_create (c);
+    }
+}
+
+static cairo_surface_t *
+marker_layer_create (SeriesCache * c)
+{
+  int scale = c->key.scale;
+  int width = c->key.width * scale, height = c->key.height * scale;
+
+  marker_sprites_ensure (c);
+
+  cairo_surface_t *layer =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  marker_layer_blit (layer, 0, c->pos, c->n, c->sprites, c->sprite_half,
+                     scale);
+  cairo_surface_set_device_scale (layer, scale, scale);
+  return layer;
+}
+
+static void
+series_cache_free (gpointer data)
+{
+  SeriesCache *c = data;
+  g_free (c->pos);
+  g_clear_pointer (&c->markers, cairo_surface_destroy);
+  g_free (c->line_path.data);
+  marker_sprites_free (c);
+  g_free (c);
+}
+
+static SeriesCache *
+series_get_cache (BScatterLineView * scat, BScatterSeries * series)
+{
+  SeriesCache *c = g_hash_table_lookup (scat->cache, series);
+  if (c == NULL)
+    {
+      c = g_new0 (SeriesCache, 1);
+      g_hash_table_insert (scat->cache, series, c);
+    }
+  if (!c->style_valid)
+    {
+      SeriesStyle *st = &c->style;
+      GdkRGBA *line_color, *marker_color;
+      g_object_get (series, "draw-line", &st->draw_line,
+                            "line-width", &st->line_width,
+                            "line-color", &line_color,
+                            "dashing", &st->dash,
+                            "marker", &st->marker,
+                            "marker-color", &marker_color,
+                            "marker-size", &st->marker_size,
+                            "decimation", &st->decimation, NULL);
+      st->line_color = *line_color;
+      st->marker_color = *marker_color;
+      marker_sprites_free (c);
+      c->style_valid = TRUE;
+    }
+  return c;
+}
+
+static void
+series_key_init (SeriesKey * k, GtkWidget * w, BVector * xdata,
+                 BVector * ydata, BData * xerr, BData * yerr,
+                 BViewInterval * vi_x, BViewInterval * vi_y)
+{
+  /* cleared so the keys can be compared with memcmp */
+  memset (k, 0, sizeof (SeriesKey));
+  k->xdata = xdata;
+  k->ydata = ydata;
+  k->xerr = xerr;
+  k->yerr = yerr;
+  k->xgen = xdata ? b_data_get_generation (B_DATA (xdata)) : 0;
+  k->ygen = b_data_get_generation (B_DATA (ydata));
+  k->xerrgen = xerr ? b_data_get_generation (xerr) : 0;
+  k->yerrgen = yerr ? b_data_get_generation (yerr) : 0;
+  b_view_interval_range (vi_x, &k->x0, &k->x1);
+  b_view_interval_range (vi_y, &k->y0, &k->y1);
+  k->xtype = b_view_interval_get_vi_type (vi_x);
+  k->ytype = b_view_interval_get_vi_type (vi_y);
+  k->width = gtk_widget_get_allocated_width (w);
+  k->height = gtk_widget_get_allocated_height (w);
+  k->scale = gtk_widget_get_scale_factor (w);
+}
+
+/* Build the path of a polyline directly, starting a new subpath after each
+ * NaN point. */
+static void
+line_path_build (cairo_path_t * path, const BPoint * pos, int n)
+{
+  cairo_path_data_t *d = g_new (cairo_path_data_t, 2 * n);
+  gboolean gap = TRUE;
+  int i, k = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      if (isnan (pos[i].x) || isnan (pos[i].y))
+        {
+          gap = TRUE;
+          continue;
+        }
+      d[k].header.type = gap ? CAIRO_PATH_MOVE_TO : CAIRO_PATH_LINE_TO;
+      d[k].header.length = 2;
+      d[k + 1].point.x = pos[i].x;
+      d[k + 1].point.y = pos[i].y;
+      k += 2;
+      gap = FALSE;
+    }
+  path->status = CAIRO_STATUS_SUCCESS;
+  path->data = d;
+  path->num_data = k;
+}
+
+/* What the geometry of a series is built from: the points that need to be
+ * drawn, in the native types of the data, and the view they are drawn in. */
+typedef struct
+{
+  gconstpointer x, y;           /* from point i0 on; NULL x for the index */
+  BElementType xtype, ytype;
+  unsigned int i0;
+  int n;
+  BViewInterval *vi_x, *vi_y;
+  int width, height, scale;
+  gboolean decimate;            /* whether the line may be decimated */
+  gboolean all_points;          /* markers or error bars need every point */
+} SeriesSource;
+
+/* find the points of a series that need to be drawn, returning FALSE if
+ * there are none */
+static gboolean
+series_source_init (SeriesSource * s, GtkWidget * w, BVector * xdata,
+                    BVector * ydata, const SeriesStyle * st,
+                    gboolean all_points, BViewInterval * vi_x,
+                    BViewInterval * vi_y)
+{
+  int N;
+  unsigned int i0, i1;
 
   if (xdata == NULL)
     {
@@ -668,20 +1241,58 @@ series_draw (gpointer data, gpointer user_data)
       N = MIN (b_vector_get_len (xdata), b_vector_get_len (ydata));
     }
 
+  /* for sorted X, only the points in view and one neighbour on each side
+     need to be drawn */
+  if (N > 0 && index_window (vi_x, xdata, N, &i0, &i1))
+    {
+      i0 = (i0 > 0) ? i0 - 1 : 0;
+      i1 = MIN (i1 + 1, (unsigned int) N);
+      N = i1 - i0;
+    }
+  else
+    i0 = 0;
+
   if (N < 1)
+    return FALSE;
+
+  s->i0 = i0;
+  s->n = N;
+  s->x = NULL;
+  s->xtype = B_ELEMENT_TYPE_DOUBLE;
+  if (xdata != NULL)
     {
-      g_clear_object(&xdata);
-      g_clear_object(&ydata);
-      return;
+      s->x = b_vector_get_native_values (xdata, &s->xtype);
+      s->x = (const char *) s->x + i0 * b_element_type_get_size (s->xtype);
     }
+  s->y = b_vector_get_native_values (ydata, &s->ytype);
+  s->y = (const char *) s->y + i0 * b_element_type_get_size (s->ytype);
+  s->vi_x = vi_x;
+  s->vi_y = vi_y;
+  s->width = gtk_widget_get_allocated_width (w);
+  s->height = gtk_widget_get_allocated_height (w);
+  s->scale = gtk_widget_get_scale_factor (w);
+  s->all_points = all_points;
+  s->decimate = st->draw_line && N > 1
+    && use_decimation (st->decimation, xdata, N, st->dash,
+                       s->scale * s->width);
+  return TRUE;
+}
 
+/* Convert the points of @s to pixel coordinates and build the path of the
+ * line through them in @line_path. This only uses its arguments, so that it
+ * can run in the pool threads. Returns the points, and sets @ratio to the
+ * decimation ratio of the line, or to zero if there is no line. */
+static BPoint *
+series_geometry_build (const SeriesSource * s, const SeriesStyle * st,
+                       cairo_path_t * line_path, double *ratio)
+{
+  int i, N = s->n;
   BPoint *pos = g_new (BPoint, N);
   double *buffer = g_new (double, N);
 
-  if (xdata != NULL)
+  if (s->x != NULL)
     {
-      const double *xraw = b_vector_get_values (xdata);
-      b_view_interval_conv_bulk (vi_x, xraw, buffer, N);
+      b_view_interval_conv_bulk_typed (s->vi_x, s->x, s->xtype, buffer, N);
 
       for (i = 0; i < N; i++)
       {
@@ -692,260 +1303,1425 @@ series_draw (gpointer data, gpointer user_data)
     {
       for (i = 0; i < N; i++)
       {
-        pos[i].x = b_view_interval_conv (vi_x, (double) i);
+        pos[i].x = b_view_interval_conv (s->vi_x, (double) (s->i0 + i));
       }
     }
 
-  const double *yraw = b_vector_get_values (ydata);
-
-  b_view_interval_conv_bulk (vi_y, yraw, buffer, N);
+  b_view_interval_conv_bulk_typed (s->vi_y, s->y, s->ytype, buffer, N);
   for (i = 0; i < N; i++)
     {
       pos[i].y = buffer[i];
     }
+  g_free (buffer);
 
-  _view_conv_bulk (w, pos, pos, N);
+  /* as _view_conv_bulk () */
+  for (i = 0; i < N; i++)
+    {
+      pos[i].x *= s->width;
+      pos[i].y = (1.0 - pos[i].y) * s->height;
+    }
 
-#if PROFILE
-  double te = g_timer_elapsed (t, NULL);
-  g_message ("scatter view before draw: %f ms", N, te * 1000);
-#endif
+  line_path->status = CAIRO_STATUS_SUCCESS;
+  line_path->data = NULL;
+  line_path->num_data = 0;
+  *ratio = 0.0;
 
-  gboolean draw_line;
-  double line_width;
-  GdkRGBA *line_color;
-  BDashing dash;
+  if (st->draw_line && N > 1)
+    {
+      BPoint *line = pos;
+      int n_line = N;
+      if (s->decimate)
+        {
+          /* markers and error bars still need every point */
+          if (s->all_points)
+            line = g_new (BPoint, N);
+          n_line = decimate_m4 (pos, line, N, s->scale);
+        }
+      *ratio = n_line > 0 ? (double) N / n_line : 1.0;
+      line_path_build (line_path, line, n_line);
+      if (line != pos)
+        g_free (line);
+    }
+  return pos;
+}
 
-  g_object_get (series, "draw-line", &draw_line, "line-width", &line_width,
-		"line-color", &line_color, "dashing", &dash, NULL);
+static void
+series_cache_update (SeriesCache * c, BScatterSeries * series,
+                     GtkWidget * w, BViewInterval * vi_x,
+                     BViewInterval * vi_y)
+{
+  const SeriesStyle *st = &c->style;
+  SeriesSource s;
+  double ratio;
+
+  g_clear_pointer (&c->pos, g_free);
+  g_clear_pointer (&c->markers, cairo_surface_destroy);
+  g_clear_pointer (&c->line_path.data, g_free);
+  c->line_path.num_data = 0;
+  c->n = 0;
+
+  if (!series_source_init (&s, w, c->key.xdata, c->key.ydata, st,
+                           st->marker != B_MARKER_NONE || c->key.xerr != NULL
+                           || c->key.yerr != NULL, vi_x, vi_y))
+    return;
 
-  gboolean found_nan = FALSE;
+  c->i0 = s.i0;
+  c->n = s.n;
+  c->pos = series_geometry_build (&s, st, &c->line_path, &ratio);
+  if (ratio > 0)
+    _b_scatter_series_set_decimation_ratio (series, ratio);
+}
 
-  if (draw_line && N > 1)
-    {
-      cairo_save (cr);
-      cairo_set_line_width (cr, line_width);
+static void
+stroke_line_path (cairo_t * cr, const SeriesStyle * st,
+                  const cairo_path_t * path)
+{
+  cairo_save (cr);
+  cairo_set_line_width (cr, st->line_width);
 
-      cairo_set_source_rgba (cr, line_color->red, line_color->green,
-			     line_color->blue, line_color->alpha);
+  cairo_set_source_rgba (cr, st->line_color.red, st->line_color.green,
+                         st->line_color.blue, st->line_color.alpha);
 
-      _b_dashing_set (dash, line_width, cr);
+  _b_dashing_set (st->dash, st->line_width, cr);
 
-      if(isnan(pos[0].x) || isnan(pos[0].y))
-        found_nan = TRUE;
-      else
-        cairo_move_to (cr, pos[0].x, pos[0].y);
-      for (i = 1; i < N; i++)
-      {
-        if(isnan(pos[i].x) || isnan(pos[i].y)) {
-          found_nan = TRUE;
-        }
-        else {
-          if(found_nan)
-            cairo_move_to(cr, pos[i].x, pos[i].y);
-          else
-            cairo_line_to (cr, pos[i].x, pos[i].y);
-          found_nan = FALSE;
-        }
-      }
-      cairo_stroke (cr);
-      cairo_restore (cr);
+  cairo_append_path (cr, path);
+  cairo_stroke (cr);
+  cairo_restore (cr);
+}
+
+/* the errors in @err of the @n points from @i0, or NULL if @err is a scalar,
+ * with its value in @fixed */
+static double *
+error_values_new (BData * err, unsigned int i0, int n, double *fixed)
+{
+  int i;
+
+  *fixed = 0.0;
+  if (B_IS_SCALAR (err))
+    {
+      *fixed = b_scalar_get_value (B_SCALAR (err));
+      return NULL;
     }
 
-  GdkRGBA *marker_color;
-  double marker_size;
-  BMarker marker_type;
+  unsigned int len = b_vector_get_len (B_VECTOR (err));
+  const double *v = b_vector_get_values (B_VECTOR (err));
+  double *e = g_new (double, n);
+  for (i = 0; i < n; i++)
+    e[i] = (i0 + i < len) ? v[i0 + i] : NAN;
+  return e;
+}
+
+/* append the error bars of the @n points at @pos along @ax to the path of
+ * @cr, from the values @raw of the points on that axis and their errors
+ * @err, or @fixed_err for all of them if @err is NULL */
+static void
+error_bars_path (cairo_t * cr, const BPoint * pos, int n, const double *raw,
+                 const double *err, double fixed_err, double half,
+                 BViewInterval * vi, BAxisType ax, int width, int height)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      double err_val = err ? err[i] : fixed_err;
+      if (isnan (pos[i].x) || isnan (pos[i].y))
+        continue;
+      if (ax == B_AXIS_TYPE_X)
+        {
+          double lo = b_view_interval_conv (vi, raw[i] - err_val) * width;
+          double hi = b_view_interval_conv (vi, raw[i] + err_val) * width;
+          double y = pos[i].y;
+          cairo_move_to (cr, lo, y - half);
+          cairo_line_to (cr, lo, y + half);
+          cairo_move_to (cr, lo, y);
+          cairo_line_to (cr, hi, y);
+          cairo_move_to (cr, hi, y - half);
+          cairo_line_to (cr, hi, y + half);
+        }
+      else
+        {
+          double lo = (1.0 - b_view_interval_conv (vi, raw[i] - err_val)) * height;
+          double hi = (1.0 - b_view_interval_conv (vi, raw[i] + err_val)) * height;
+          double x = pos[i].x;
+          cairo_move_to (cr, x - half, lo);
+          cairo_line_to (cr, x + half, lo);
+          cairo_move_to (cr, x, lo);
+          cairo_line_to (cr, x, hi);
+          cairo_move_to (cr, x - half, hi);
+          cairo_line_to (cr, x + half, hi);
+        }
+    }
+}
 
-  g_object_get (series, "marker-color", &marker_color,
-                        "marker-size", &marker_size,
-                        "marker", &marker_type, NULL);
+/* append the error bars of the cached points along @ax to the path of @cr */
+static void
+series_error_bars_path (cairo_t * cr, GtkWidget * w, const SeriesCache * c,
+                        BVector * data, BData * err, BViewInterval * vi,
+                        BAxisType ax)
+{
+  double fixed;
+  double *e = error_values_new (err, c->i0, c->n, &fixed);
+
+  error_bars_path (cr, c->pos, c->n, b_vector_get_values (data) + c->i0, e,
+                   fixed, c->style.marker_size / 2, vi, ax,
+                   gtk_widget_get_allocated_width (w),
+                   gtk_widget_get_allocated_height (w));
+  g_free (e);
+}
+
+static void
+series_draw_error_bars (cairo_t * cr, GtkWidget * w, const SeriesCache * c,
+                        BVector * xdata, BVector * ydata, BData * xerr,
+                        BData * yerr, BViewInterval * vi_x,
+                        BViewInterval * vi_y)
+{
+  const SeriesStyle *st = &c->style;
 
   if(xerr != NULL && xdata != NULL) {
-    const double *xraw = b_vector_get_values (xdata);
     cairo_save (cr);
-    cairo_set_line_width (cr, line_width);
+    cairo_set_line_width (cr, st->line_width);
+
+    cairo_set_source_rgba (cr, st->marker_color.red, st->marker_color.green,
+         st->marker_color.blue, st->marker_color.alpha);
+
+    series_error_bars_path (cr, w, c, xdata, xerr, vi_x, B_AXIS_TYPE_X);
+    cairo_stroke(cr);
+    cairo_restore(cr);
+  }
+
+  if(yerr != NULL) {
+    cairo_save (cr);
+    cairo_set_line_width (cr, st->line_width);
+
+    cairo_set_source_rgba (cr, st->marker_color.red, st->marker_color.green,
+         st->marker_color.blue, st->marker_color.alpha);
+
+    series_error_bars_path (cr, w, c, ydata, yerr, vi_y, B_AXIS_TYPE_Y);
+    cairo_stroke(cr);
+    cairo_restore(cr);
+  }
+}
+
+/* the cache of @series, brought up to date with the data and view */
+static SeriesCache *
+series_cache_get_current (BScatterLineView * scat, BScatterSeries * series,
+                          BVector * xdata, BVector * ydata, BData * xerr,
+                          BData * yerr, BViewInterval * vi_x,
+                          BViewInterval * vi_y)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  SeriesCache *c = series_get_cache (scat, series);
+  SeriesKey key;
+
+  series_key_init (&key, w, xdata, ydata, xerr, yerr, vi_x, vi_y);
+  if (!c->valid || memcmp (&key, &c->key, sizeof (SeriesKey)) != 0)
+    {
+      c->key = key;
+      series_cache_update (c, series, w, vi_x, vi_y);
+      c->valid = TRUE;
+    }
+  return c;
+}
+
+struct draw_struct
+{
+  BScatterLineView *scat;
+  cairo_t *cr;
+};
+
+static void
+series_draw (gpointer data, gpointer user_data)
+{
+  BScatterSeries *series = B_SCATTER_SERIES (data);
+
+  if(!b_scatter_series_get_show(series))
+    return;
+  struct draw_struct *s = user_data;
+  BScatterLineView *scat = s->scat;
+  cairo_t *cr = s->cr;
+  GtkWidget *w = GTK_WIDGET (scat);
+
+  BVector *xdata, *ydata;
+  BData *xerr, *yerr;
+  g_object_get (series, "x-data", &xdata, "y-data", &ydata,
+                        "x-err", &xerr, "y-err", &yerr, NULL);
+
+  BViewInterval *vi_x, *vi_y;
+
+#if PROFILE
+  GTimer *t = g_timer_new ();
+#endif
+
+  if (ydata == NULL)
+    {
+      g_clear_object(&xdata);
+      g_clear_object(&xerr);
+      g_clear_object(&yerr);
+      return;
+    }
+
+  vi_x =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+						B_AXIS_TYPE_X);
+
+  vi_y =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+						B_AXIS_TYPE_Y);
+
+  SeriesCache *c = series_cache_get_current (scat, series, xdata, ydata,
+                                             xerr, yerr, vi_x, vi_y);
+  const SeriesStyle *st = &c->style;
+
+  if (c->n < 1)
+    {
+      g_clear_object(&xdata);
+      g_clear_object(&ydata);
+      g_clear_object(&xerr);
+      g_clear_object(&yerr);
+      return;
+    }
+
+#if PROFILE
+  double te = g_timer_elapsed (t, NULL);
+  g_message ("scatter view before draw: %f ms", te * 1000);
+#endif
+
+  if (st->draw_line && c->line_path.num_data > 0)
+    stroke_line_path (cr, st, &c->line_path);
+
+  series_draw_error_bars (cr, w, c, xdata, ydata, xerr, yerr, vi_x, vi_y);
+
+  if (st->marker != B_MARKER_NONE)
+    {
+      if (target_is_vector (cr))
+        draw_markers_path (cr, st, c->pos, c->n);
+      else
+        {
+          if (c->markers == NULL)
+            c->markers = marker_layer_create (c);
+          cairo_set_source_surface (cr, c->markers, 0.0, 0.0);
+          cairo_paint (cr);
+        }
+    }
+
+#if PROFILE
+  gint64 now = g_get_real_time();
+  gint64 then = y_data_get_timestamp(B_DATA(xdata));
+  te = g_timer_elapsed (t, NULL);
+  g_message ("scatter view draw %d points: %f ms", c->n, te * 1000);
+  g_message ("microseconds: %d",(int) (now-then));
+  g_timer_destroy (t);
+#endif
+  g_clear_object(&xdata);
+  g_clear_object(&ydata);
+  g_clear_object(&xerr);
+  g_clear_object(&yerr);
+}
+
+static void
+scatter_view_measure (GtkWidget      *widget,
+         GtkOrientation  orientation,
+         int             for_size,
+         int            *minimum_size,
+         int            *natural_size,
+         int            *minimum_baseline,
+         int            *natural_baseline)
+{
+  *minimum_size=1;
+  *natural_size=20;
+  //*minimum_baseline=1;
+  //*natural_baseline=20;
+}
+
+/* ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** */
+
+/* The series are drawn into a render node that is kept until the data, the
+ * view intervals, the size or a series' style change. The cursors and the
+ * zoom box are drawn on top of it in every snapshot. */
+
+static void
+scatter_view_draw_data (GtkWidget * w, cairo_t * cr)
+{
+  BScatterLineView *scat = B_SCATTER_LINE_VIEW (w);
+
+  struct draw_struct *s = g_malloc (sizeof (struct draw_struct));
+  s->scat = scat;
+  s->cr = cr;
+
+  g_list_foreach (scat->series, series_draw, s);
+
+  g_free (s);
+}
+
+/* whether every series cache matches the current data and view */
+static gboolean
+series_caches_current (BScatterLineView * scat)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  GList *l;
+
+  BViewInterval *vi_x =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *vi_y =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
+
+  for (l = scat->series; l != NULL; l = l->next)
+    {
+      BScatterSeries *series = B_SCATTER_SERIES (l->data);
+      BVector *xdata, *ydata;
+      BData *xerr, *yerr;
+      gboolean current = TRUE;
+
+      if (!b_scatter_series_get_show (series))
+        continue;
+
+      g_object_get (series, "x-data", &xdata, "y-data", &ydata,
+                            "x-err", &xerr, "y-err", &yerr, NULL);
+      if (ydata != NULL)
+        {
+          SeriesCache *c = g_hash_table_lookup (scat->cache, series);
+          SeriesKey key;
+          series_key_init (&key, w, xdata, ydata, xerr, yerr, vi_x, vi_y);
+          current = c != NULL
+            && ((c->valid
+                 && memcmp (&key, &c->key, sizeof (SeriesKey)) == 0)
+                || (c->raster_valid
+                    && memcmp (&key, &c->raster_key, sizeof (SeriesKey)) == 0));
+        }
+      g_clear_object (&xdata);
+      g_clear_object (&ydata);
+      g_clear_object (&xerr);
+      g_clear_object (&yerr);
+      if (!current)
+        return FALSE;
+    }
+  return TRUE;
+}
+
+static gboolean
+data_layer_is_current (BScatterLineView * scat)
+{
+  return scat->data_node != NULL && scat->data_node_valid
+    && series_caches_current (scat);
+}
+
+static void
+data_layer_invalidate (BScatterLineView * scat)
+{
+  scat->data_node_valid = FALSE;
+  scat->frame_valid = FALSE;
+}
+
+/* Threaded rendering: the points in view of every shown series are copied on
+ * the main thread, with the view intervals and the style. A shared thread
+ * pool converts them to pixels and builds the paths, one task per series,
+ * and then rasterizes the data layer in vertical strips. Starting a new frame
+ * cancels the one in flight; its strips are dropped, and only the latest
+ * frame is composited. */
+
+typedef struct
+{
+  double *val;                  /* the values of the points on the axis */
+  double *err;                  /* their errors, or NULL for fixed */
+  double fixed;
+} RasterErrors;
+
+typedef struct
+{
+  /* copied on the main thread */
+  BScatterSeries *series;       /* not owned, only compared */
+  SeriesStyle style;
+  SeriesSource source;          /* owns its points and intervals */
+  RasterErrors *errors[2];
+  cairo_surface_t *sprites[SPRITE_STEPS * SPRITE_STEPS];
+  int sprite_half;
+  /* built in the pool */
+  BPoint *pos;                  /* NULL unless there are markers */
+  cairo_path_t line_path;
+  cairo_path_t *err_path[2];
+  double decimation_ratio;
+} RasterSeries;
+
+typedef struct
+{
+  GCancellable *cancellable;
+  BScatterLineView *view;       /* main thread only, NULL once dropped */
+  GPtrArray *series;            /* RasterSeries, read-only once the strips
+                                   are queued */
+  int width, height, scale;
+  int strip_width;              /* in device pixels */
+  int n_strips;
+  cairo_surface_t **strips;
+  gint building;                /* series still being built */
+  gint pending;                 /* strips still being drawn */
+} RasterFrame;
+
+typedef struct
+{
+  RasterFrame *frame;
+  gboolean build;               /* build series @index, or draw strip @index */
+  int index;
+} RasterTask;
+
+static GThreadPool *raster_pool = NULL;
+
+static RasterErrors *
+raster_errors_new (BVector * data, BData * err, unsigned int i0, int n)
+{
+  RasterErrors *e = g_new (RasterErrors, 1);
+  e->val = g_memdup2 (b_vector_get_values (data) + i0, n * sizeof (double));
+  e->err = error_values_new (err, i0, n, &e->fixed);
+  return e;
+}
+
+static void
+raster_errors_free (RasterErrors * e)
+{
+  g_free (e->val);
+  g_free (e->err);
+  g_free (e);
+}
+
+static void
+raster_series_free (gpointer data)
+{
+  RasterSeries *r = data;
+  int k;
+  g_free ((gpointer) r->source.x);
+  g_free ((gpointer) r->source.y);
+  g_clear_object (&r->source.vi_x);
+  g_clear_object (&r->source.vi_y);
+  g_free (r->line_path.data);
+  for (k = 0; k < 2; k++)
+    {
+      g_clear_pointer (&r->errors[k], raster_errors_free);
+      g_clear_pointer (&r->err_path[k], cairo_path_destroy);
+    }
+  g_free (r->pos);
+  for (k = 0; k < SPRITE_STEPS * SPRITE_STEPS; k++)
+    g_clear_pointer (&r->sprites[k], cairo_surface_destroy);
+  g_free (r);
+}
+
+static void
+raster_frame_clear (gpointer data)
+{
+  RasterFrame *frame = data;
+  int i;
+  g_object_unref (frame->cancellable);
+  g_ptr_array_unref (frame->series);
+  for (i = 0; i < frame->n_strips; i++)
+    g_clear_pointer (&frame->strips[i], cairo_surface_destroy);
+  g_free (frame->strips);
+}
+
+static void
+raster_frame_drop (gpointer data)
+{
+  RasterFrame *frame = data;
+  g_cancellable_cancel (frame->cancellable);
+  frame->view = NULL;
+  g_atomic_rc_box_release_full (frame, raster_frame_clear);
+}
+
+/* runs in a pool thread */
+static void
+raster_series_build (RasterSeries * r)
+{
+  const SeriesSource *s = &r->source;
+  int k;
+
+  r->pos = series_geometry_build (s, &r->style, &r->line_path,
+                                  &r->decimation_ratio);
+
+  if (r->errors[0] != NULL || r->errors[1] != NULL)
+    {
+      cairo_surface_t *scratch =
+        cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+      cairo_t *cr = cairo_create (scratch);
+      for (k = 0; k < 2; k++)
+        {
+          RasterErrors *e = r->errors[k];
+          if (e == NULL)
+            continue;
+          error_bars_path (cr, r->pos, s->n, e->val, e->err, e->fixed,
+                           r->style.marker_size / 2,
+                           k == 0 ? s->vi_x : s->vi_y,
+                           k == 0 ? B_AXIS_TYPE_X : B_AXIS_TYPE_Y,
+                           s->width, s->height);
+          r->err_path[k] = cairo_copy_path (cr);
+          cairo_new_path (cr);
+        }
+      cairo_destroy (cr);
+      cairo_surface_destroy (scratch);
+    }
+
+  if (r->style.marker == B_MARKER_NONE)
+    g_clear_pointer (&r->pos, g_free);
+}
+
+static void
+raster_series_draw (cairo_t * cr, int x0, const RasterSeries * r, int scale)
+{
+  const SeriesStyle *st = &r->style;
+  int k;
+
+  if (r->line_path.num_data > 0)
+    stroke_line_path (cr, st, &r->line_path);
+
+  for (k = 0; k < 2; k++)
+    {
+      if (r->err_path[k] == NULL)
+        continue;
+      cairo_save (cr);
+      cairo_set_line_width (cr, st->line_width);
+      cairo_set_source_rgba (cr, st->marker_color.red, st->marker_color.green,
+                             st->marker_color.blue, st->marker_color.alpha);
+      cairo_append_path (cr, r->err_path[k]);
+      cairo_stroke (cr);
+      cairo_restore (cr);
+    }
+
+  if (r->pos != NULL)
+    marker_layer_blit (cairo_get_target (cr), x0, r->pos, r->source.n,
+                       r->sprites, r->sprite_half, scale);
+}
+
+static gboolean
+raster_frame_done (gpointer user_data)
+{
+  RasterFrame *frame = user_data;
+  BScatterLineView *scat = frame->view;
+  guint i;
+
+  if (scat != NULL && scat->frame == frame
+      && !g_cancellable_is_cancelled (frame->cancellable))
+    {
+      graphene_rect_t bounds;
+      graphene_rect_init (&bounds, 0, 0, frame->width, frame->height);
+      GtkSnapshot *ds = gtk_snapshot_new ();
+      cairo_t *cr = gtk_snapshot_append_cairo (ds, &bounds);
+      for (i = 0; i < (guint) frame->n_strips; i++)
+        {
+          cairo_set_source_surface (cr, frame->strips[i], 0.0, 0.0);
+          cairo_paint (cr);
+        }
+      cairo_destroy (cr);
+      g_clear_pointer (&scat->data_node, gsk_render_node_unref);
+      scat->data_node = gtk_snapshot_free_to_node (ds);
+      /* stays invalid if anything changed while the frame was rendered */
+      scat->data_node_valid = scat->frame_valid;
+      for (i = 0; i < frame->series->len; i++)
+        {
+          RasterSeries *r = g_ptr_array_index (frame->series, i);
+          if (r->decimation_ratio > 0
+              && g_list_find (scat->series, r->series) != NULL)
+            _b_scatter_series_set_decimation_ratio (r->series,
+                                                    r->decimation_ratio);
+        }
+      scat->frame = NULL;
+      gtk_widget_queue_draw (GTK_WIDGET (scat));
+      /* drop the view's reference */
+      g_atomic_rc_box_release_full (frame, raster_frame_clear);
+    }
+
+  g_atomic_rc_box_release_full (frame, raster_frame_clear);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+raster_frame_push (RasterFrame * frame, gboolean build, int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      RasterTask *task = g_new (RasterTask, 1);
+      task->frame = g_atomic_rc_box_acquire (frame);
+      task->build = build;
+      task->index = i;
+      g_thread_pool_push (raster_pool, task, NULL);
+    }
+}
+
+/* runs in a pool thread */
+static void
+raster_task_run (gpointer data, gpointer user_data)
+{
+  RasterTask *task = data;
+  RasterFrame *frame = task->frame;
+
+  if (task->build)
+    {
+      if (!g_cancellable_is_cancelled (frame->cancellable))
+        {
+          raster_series_build (g_ptr_array_index (frame->series, task->index));
+          /* the strips are drawn once every series is built */
+          if (g_atomic_int_dec_and_test (&frame->building))
+            raster_frame_push (frame, FALSE, frame->n_strips);
+        }
+      g_atomic_rc_box_release_full (frame, raster_frame_clear);
+      g_free (task);
+      return;
+    }
+
+  int x0 = task->index * frame->strip_width;
+  int w = MIN (frame->strip_width, frame->width * frame->scale - x0);
+  guint i;
+
+  if (!g_cancellable_is_cancelled (frame->cancellable))
+    {
+      cairo_surface_t *strip =
+        cairo_image_surface_create (CAIRO_FORMAT_ARGB32, w,
+                                    frame->height * frame->scale);
+      cairo_surface_set_device_offset (strip, -x0, 0);
+      cairo_surface_set_device_scale (strip, frame->scale, frame->scale);
+      cairo_t *cr = cairo_create (strip);
+      for (i = 0; i < frame->series->len; i++)
+        {
+          if (g_cancellable_is_cancelled (frame->cancellable))
+            break;
+          raster_series_draw (cr, x0, g_ptr_array_index (frame->series, i),
+                              frame->scale);
+        }
+      cairo_destroy (cr);
+      frame->strips[task->index] = strip;
+    }
+
+  if (g_atomic_int_dec_and_test (&frame->pending))
+    g_idle_add (raster_frame_done, g_atomic_rc_box_acquire (frame));
+
+  g_atomic_rc_box_release_full (frame, raster_frame_clear);
+  g_free (task);
+}
+
+/* a copy of the range and scaling of @vi, for the pool threads to convert
+ * with while @vi goes on changing */
+static BViewInterval *
+view_interval_copy (BViewInterval * vi)
+{
+  BViewInterval *copy = b_view_interval_new ();
+  double a, b;
+
+  if (b_view_interval_is_logarithmic (vi))
+    b_view_interval_scale_logarithmically (copy, 10.0);
+  b_view_interval_range (vi, &a, &b);
+  b_view_interval_set (copy, a, b);
+  return copy;
+}
+
+static RasterSeries *
+raster_series_new (BScatterLineView * scat, BScatterSeries * series)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  BVector *xdata, *ydata;
+  BData *xerr, *yerr;
+  RasterSeries *r = NULL;
+  SeriesSource s;
+  int k;
+
+  g_object_get (series, "x-data", &xdata, "y-data", &ydata,
+                        "x-err", &xerr, "y-err", &yerr, NULL);
+  if (ydata == NULL)
+    goto out;
+
+  BViewInterval *vi_x =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *vi_y =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
+
+  SeriesCache *c = series_get_cache (scat, series);
+  const SeriesStyle *st = &c->style;
+  gboolean xbars = xerr != NULL && xdata != NULL, ybars = yerr != NULL;
+
+  series_key_init (&c->raster_key, w, xdata, ydata, xerr, yerr, vi_x, vi_y);
+  c->raster_valid = TRUE;
+
+  if (!series_source_init (&s, w, xdata, ydata, st,
+                           st->marker != B_MARKER_NONE || xbars || ybars,
+                           vi_x, vi_y))
+    goto out;
+
+  r = g_new0 (RasterSeries, 1);
+  r->series = series;
+  r->style = *st;
+  r->source = s;
+  r->source.x = s.x ? g_memdup2 (s.x, s.n * b_element_type_get_size (s.xtype))
+                    : NULL;
+  r->source.y = g_memdup2 (s.y, s.n * b_element_type_get_size (s.ytype));
+  r->source.vi_x = view_interval_copy (vi_x);
+  r->source.vi_y = view_interval_copy (vi_y);
+  if (xbars)
+    r->errors[0] = raster_errors_new (xdata, xerr, s.i0, s.n);
+  if (ybars)
+    r->errors[1] = raster_errors_new (ydata, yerr, s.i0, s.n);
+
+  if (st->marker != B_MARKER_NONE)
+    {
+      marker_sprites_ensure (c);
+      for (k = 0; k < SPRITE_STEPS * SPRITE_STEPS; k++)
+        r->sprites[k] = cairo_surface_reference (c->sprites[k]);
+      r->sprite_half = c->sprite_half;
+    }
+
+out:
+  g_clear_object (&xdata);
+  g_clear_object (&ydata);
+  g_clear_object (&xerr);
+  g_clear_object (&yerr);
+  return r;
+}
+
+static void
+raster_frame_start (BScatterLineView * scat)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  GList *l;
+
+  if (raster_pool == NULL)
+    raster_pool = g_thread_pool_new (raster_task_run, NULL,
+                                     g_get_num_processors (), FALSE, NULL);
+
+  g_clear_pointer (&scat->frame, raster_frame_drop);
+
+  RasterFrame *frame = g_atomic_rc_box_new0 (RasterFrame);
+  frame->cancellable = g_cancellable_new ();
+  frame->view = scat;
+  frame->series = g_ptr_array_new_with_free_func (raster_series_free);
+  frame->width = gtk_widget_get_allocated_width (w);
+  frame->height = gtk_widget_get_allocated_height (w);
+  frame->scale = gtk_widget_get_scale_factor (w);
+
+  for (l = scat->series; l != NULL; l = l->next)
+    {
+      BScatterSeries *series = B_SCATTER_SERIES (l->data);
+      if (b_scatter_series_get_show (series))
+        {
+          RasterSeries *r = raster_series_new (scat, series);
+          if (r != NULL)
+            g_ptr_array_add (frame->series, r);
+        }
+    }
+
+  int device_width = frame->width * frame->scale;
+  frame->n_strips = CLAMP (device_width / 128, 1, (int) g_get_num_processors ());
+  frame->strip_width = (device_width + frame->n_strips - 1) / frame->n_strips;
+  frame->strips = g_new0 (cairo_surface_t *, frame->n_strips);
+  frame->pending = frame->n_strips;
+  frame->building = frame->series->len;
+
+  scat->frame = frame;
+  scat->frame_valid = TRUE;
+
+  if (frame->series->len > 0)
+    raster_frame_push (frame, TRUE, frame->series->len);
+  else
+    raster_frame_push (frame, FALSE, frame->n_strips);
+}
+
+/* Progressive rendering: a strided subset of every large series is drawn
+ * first, then the full image is built in an offscreen surface during idle
+ * time, a few milliseconds at a time, and replaces the preview when it is
+ * complete. Any change to the data or the view restarts from the preview. */
+
+#define PROGRESSIVE_COARSE_POINTS 16384
+#define PROGRESSIVE_CHUNK 16384
+#define PROGRESSIVE_SLICE_US 8000
+
+enum
+{
+  REFINE_LINE,
+  REFINE_ERRORS,
+  REFINE_MARKERS
+};
+
+/* draw every stride-th point of @series, returning whether any were left
+ * out */
+static gboolean
+series_draw_coarse (BScatterLineView * scat, BScatterSeries * series,
+                    cairo_t * cr)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  BVector *xdata, *ydata;
+  BData *xerr, *yerr;
+  gboolean partial = FALSE;
+  int i, m;
+
+  g_object_get (series, "x-data", &xdata, "y-data", &ydata,
+                        "x-err", &xerr, "y-err", &yerr, NULL);
+  if (ydata == NULL)
+    goto out;
 
-    cairo_set_source_rgba (cr, marker_color->red, marker_color->green,
-         marker_color->blue, marker_color->alpha);
+  BViewInterval *vi_x =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *vi_y =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
 
-    gboolean fixed_err = FALSE;
-    double fixed_err_val = 0.0;
+  SeriesCache *c = series_cache_get_current (scat, series, xdata, ydata,
+                                             xerr, yerr, vi_x, vi_y);
+  const SeriesStyle *st = &c->style;
+  int line_points = c->line_path.num_data / 2;
+  int stride = (MAX (c->n, line_points) + PROGRESSIVE_COARSE_POINTS - 1)
+               / PROGRESSIVE_COARSE_POINTS;
 
-    if(B_IS_SCALAR(xerr)) {
-      fixed_err = TRUE;
-      fixed_err_val = b_scalar_get_value(B_SCALAR(xerr));
+  if (stride <= 1)
+    {
+      struct draw_struct d = { scat, cr };
+      series_draw (series, &d);
+      goto out;
     }
+  partial = TRUE;
 
-    for (i = 0; i < N; i++)
-      {
-        double err_val = fixed_err ? fixed_err_val : b_vector_get_value(B_VECTOR(xerr),i);
-        if(!isnan(pos[i].x) & !isnan(pos[i].y)) {
-          BPoint epos, epos2;
-          _view_invconv(w,&pos[i],&epos);
-          epos.x = b_view_interval_conv (vi_x, xraw[i]-err_val);
-          _view_conv(w,&epos, &epos2);
-          cairo_move_to(cr, epos2.x, epos2.y-marker_size/2);
-          cairo_line_to(cr, epos2.x, epos2.y+marker_size/2);
-          cairo_move_to(cr, epos2.x, epos2.y);
-          epos.x = b_view_interval_conv (vi_x, xraw[i]+err_val);
-          _view_conv(w,&epos, &epos2);
-          cairo_line_to(cr, epos2.x, epos2.y);
-          cairo_move_to(cr, epos2.x, epos2.y-marker_size/2);
-          cairo_line_to(cr, epos2.x, epos2.y+marker_size/2);
-          cairo_stroke(cr);
+  /* the line is thinned from its own (possibly decimated) vertices */
+  if (st->draw_line && line_points > 1)
+    {
+      cairo_path_t path;
+      const cairo_path_data_t *d = c->line_path.data;
+      cairo_path_data_t *sub = g_new (cairo_path_data_t, c->line_path.num_data);
+      int ls = (line_points + PROGRESSIVE_COARSE_POINTS - 1)
+               / PROGRESSIVE_COARSE_POINTS;
+      for (i = 0, m = 0; i < line_points; i++)
+        {
+          /* keep every subpath start so gaps are preserved */
+          if (i % ls == 0 || d[2 * i].header.type == CAIRO_PATH_MOVE_TO)
+            {
+              sub[2 * m] = d[2 * i];
+              sub[2 * m + 1] = d[2 * i + 1];
+              m++;
+            }
         }
-      }
-    cairo_restore(cr);
-  }
+      path.status = CAIRO_STATUS_SUCCESS;
+      path.data = sub;
+      path.num_data = 2 * m;
+      stroke_line_path (cr, st, &path);
+      g_free (sub);
+    }
 
-  if(yerr != NULL) {
-    cairo_save (cr);
-    cairo_set_line_width (cr, line_width);
+  if (st->marker != B_MARKER_NONE)
+    {
+      BPoint *sub = g_new (BPoint, c->n / stride + 1);
+      for (i = 0, m = 0; i < c->n; i += stride)
+        sub[m++] = c->pos[i];
+      draw_markers_path (cr, st, sub, m);
+      g_free (sub);
+    }
 
-    cairo_set_source_rgba (cr, marker_color->red, marker_color->green,
-         marker_color->blue, marker_color->alpha);
+out:
+  g_clear_object (&xdata);
+  g_clear_object (&ydata);
+  g_clear_object (&xerr);
+  g_clear_object (&yerr);
+  return partial;
+}
 
-    gboolean fixed_err = FALSE;
-    double fixed_err_val = 0.0;
+/* record the preview into the data node, returning whether it needs
+ * refining */
+static gboolean
+data_layer_draw_coarse (BScatterLineView * scat, const graphene_rect_t * bounds)
+{
+  gboolean partial = FALSE;
+  GList *l;
 
-    if(B_IS_SCALAR(yerr)) {
-      fixed_err = TRUE;
-      fixed_err_val = b_scalar_get_value(B_SCALAR(yerr));
+  GtkSnapshot *ds = gtk_snapshot_new ();
+  cairo_t *cr = gtk_snapshot_append_cairo (ds, bounds);
+  for (l = scat->series; l != NULL; l = l->next)
+    {
+      BScatterSeries *series = B_SCATTER_SERIES (l->data);
+      if (b_scatter_series_get_show (series))
+        partial |= series_draw_coarse (scat, series, cr);
     }
+  cairo_destroy (cr);
+  g_clear_pointer (&scat->data_node, gsk_render_node_unref);
+  scat->data_node = gtk_snapshot_free_to_node (ds);
+  return partial;
+}
 
-    for (i = 0; i < N; i++)
-      {
-        double err_val = fixed_err ? fixed_err_val : b_vector_get_value(B_VECTOR(yerr),i);
-        if(!isnan(pos[i].x) & !isnan(pos[i].y)) {
-          BPoint epos, epos2;
-          _view_invconv(w,&pos[i],&epos);
-          epos.y = b_view_interval_conv (vi_y, yraw[i]-err_val);
-          _view_conv(w,&epos, &epos2);
-          cairo_move_to(cr, epos2.x-marker_size/2, epos2.y);
-          cairo_line_to(cr, epos2.x+marker_size/2, epos2.y);
-          cairo_move_to(cr, epos2.x, epos2.y);
-          epos.y = b_view_interval_conv (vi_y, yraw[i]+err_val);
-          _view_conv(w,&epos, &epos2);
-          cairo_line_to(cr, epos2.x, epos2.y);
-          cairo_move_to(cr, epos2.x-marker_size/2, epos2.y);
-          cairo_line_to(cr, epos2.x+marker_size/2, epos2.y);
-          cairo_stroke(cr);
-        }
-      }
-    cairo_restore(cr);
-  }
+static void
+progressive_stop (BScatterLineView * scat)
+{
+  g_clear_handle_id (&scat->refine_id, g_source_remove);
+  g_clear_pointer (&scat->refine_surface, cairo_surface_destroy);
+}
+
+/* draw the next piece of the full image, returning FALSE when there is
+ * nothing left */
+static gboolean
+progressive_step (BScatterLineView * scat, cairo_t * cr)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  BScatterSeries *series = g_list_nth_data (scat->series, scat->refine_series);
 
-  if (marker_type != B_MARKER_NONE)
+  if (series == NULL)
+    return FALSE;
+
+  SeriesCache *c = g_hash_table_lookup (scat->cache, series);
+  if (!b_scatter_series_get_show (series) || c == NULL || !c->valid
+      || c->n < 1)
     {
-      cairo_set_source_rgba (cr, marker_color->red, marker_color->green,
-			     marker_color->blue, marker_color->alpha);
+      scat->refine_series++;
+      return TRUE;
+    }
 
-      switch (marker_type)
-      {
-        case B_MARKER_CIRCLE:
-        for (i = 0; i < N; i++)
-        {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_circle (cr, pos[i], marker_size, TRUE);
-        }
-        break;
-        case B_MARKER_OPEN_CIRCLE:
-        for (i = 0; i < N; i++)
-        {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_circle (cr, pos[i], marker_size, FALSE);
-        }
-        break;
-        case B_MARKER_SQUARE:
-        for (i = 0; i < N; i++)
-        {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_square (cr, pos[i], marker_size, TRUE);
-        }
-        break;
-        case B_MARKER_OPEN_SQUARE:
-        for (i = 0; i < N; i++)
-        {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_square (cr, pos[i], marker_size, FALSE);
-        }
-        break;
-        case B_MARKER_DIAMOND:
-        for (i = 0; i < N; i++)
-        {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_diamond (cr, pos[i], marker_size, TRUE);
-        }
-        break;
-        case B_MARKER_OPEN_DIAMOND:
-        for (i = 0; i < N; i++)
+  const SeriesStyle *st = &c->style;
+  int k0 = scat->refine_offset, k1;
+
+  switch (scat->refine_stage)
+    {
+    case REFINE_LINE:
+      if (st->draw_line && c->line_path.num_data > 0)
         {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_diamond (cr, pos[i], marker_size, FALSE);
+          int n_el = c->line_path.num_data / 2;
+          /* dashes would restart at every piece */
+          k1 = (st->dash == B_DASHING_SOLID) ?
+               MIN (k0 + PROGRESSIVE_CHUNK, n_el) : n_el;
+          /* each piece starts at the last vertex of the previous one */
+          int first = MAX (k0 - 1, 0);
+          cairo_path_t part;
+          part.status = CAIRO_STATUS_SUCCESS;
+          part.data = c->line_path.data + 2 * first;
+          part.num_data = 2 * (k1 - first);
+          stroke_line_path (cr, st, &part);
+          if (k1 < n_el)
+            {
+              scat->refine_offset = k1;
+              return TRUE;
+            }
         }
-        break;
-        case B_MARKER_X:
-        for (i = 0; i < N; i++)
+      scat->refine_stage = REFINE_ERRORS;
+      scat->refine_offset = 0;
+      return TRUE;
+    case REFINE_ERRORS:
+      {
+        BVector *xdata, *ydata;
+        BData *xerr, *yerr;
+        g_object_get (series, "x-data", &xdata, "y-data", &ydata,
+                              "x-err", &xerr, "y-err", &yerr, NULL);
+        series_draw_error_bars (cr, w, c, xdata, ydata, xerr, yerr,
+          b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                      B_AXIS_TYPE_X),
+          b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                      B_AXIS_TYPE_Y));
+        g_clear_object (&xdata);
+        g_clear_object (&ydata);
+        g_clear_object (&xerr);
+        g_clear_object (&yerr);
+      }
+      scat->refine_stage = REFINE_MARKERS;
+      return TRUE;
+    case REFINE_MARKERS:
+      if (st->marker != B_MARKER_NONE)
         {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_x (cr, pos[i], marker_size);
+          marker_sprites_ensure (c);
+          k1 = MIN (k0 + PROGRESSIVE_CHUNK, c->n);
+          marker_layer_blit (scat->refine_surface, 0, c->pos + k0, k1 - k0,
+                             c->sprites, c->sprite_half, c->key.scale);
+          if (k1 < c->n)
+            {
+              scat->refine_offset = k1;
+              return TRUE;
+            }
         }
-        break;
-        case B_MARKER_PLUS:
-        for (i = 0; i < N; i++)
+      break;
+    }
+
+  scat->refine_series++;
+  scat->refine_stage = REFINE_LINE;
+  scat->refine_offset = 0;
+  return TRUE;
+}
+
+static gboolean
+progressive_refine (gpointer user_data)
+{
+  BScatterLineView *scat = B_SCATTER_LINE_VIEW (user_data);
+  gint64 deadline = g_get_monotonic_time () + PROGRESSIVE_SLICE_US;
+  gboolean more = TRUE;
+
+  /* the snapshot restarts from a new preview */
+  if (!scat->data_node_valid || !series_caches_current (scat))
+    {
+      scat->refine_id = 0;
+      g_clear_pointer (&scat->refine_surface, cairo_surface_destroy);
+      return G_SOURCE_REMOVE;
+    }
+
+  cairo_t *cr = cairo_create (scat->refine_surface);
+  while (more && g_get_monotonic_time () < deadline)
+    more = progressive_step (scat, cr);
+  cairo_destroy (cr);
+
+  if (more)
+    return G_SOURCE_CONTINUE;
+
+  graphene_rect_t bounds;
+  graphene_rect_init (&bounds, 0, 0,
+                      gtk_widget_get_allocated_width (GTK_WIDGET (scat)),
+                      gtk_widget_get_allocated_height (GTK_WIDGET (scat)));
+  GtkSnapshot *ds = gtk_snapshot_new ();
+  cr = gtk_snapshot_append_cairo (ds, &bounds);
+  cairo_set_source_surface (cr, scat->refine_surface, 0.0, 0.0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  g_clear_pointer (&scat->data_node, gsk_render_node_unref);
+  scat->data_node = gtk_snapshot_free_to_node (ds);
+
+  scat->refine_id = 0;
+  g_clear_pointer (&scat->refine_surface, cairo_surface_destroy);
+  gtk_widget_queue_draw (GTK_WIDGET (scat));
+  return G_SOURCE_REMOVE;
+}
+
+static void
+progressive_start (BScatterLineView * scat)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  int scale = gtk_widget_get_scale_factor (w);
+
+  progressive_stop (scat);
+  scat->refine_surface =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                gtk_widget_get_allocated_width (w) * scale,
+                                gtk_widget_get_allocated_height (w) * scale);
+  cairo_surface_set_device_scale (scat->refine_surface, scale, scale);
+  scat->refine_series = 0;
+  scat->refine_stage = REFINE_LINE;
+  scat->refine_offset = 0;
+  scat->refine_id = g_idle_add (progressive_refine, scat);
+}
+
+/* Strip chart: the data layer is kept as a raster. When the data only got
+ * appended to and X only scrolled, the raster is shifted by the whole
+ * number of device pixels X moved and only the new points are drawn; the
+ * remaining fraction of a pixel is applied when the raster is shown. Any
+ * other change, including dropped points that were still in view, redraws
+ * everything. */
+
+static void
+strip_reset_tracking (BScatterLineView * scat)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, scat->cache);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      SeriesCache *c = value;
+      c->strip_gen[0] = c->key.xdata ? b_data_get_generation (B_DATA (c->key.xdata)) : 0;
+      c->strip_gen[1] = c->key.ydata ? b_data_get_generation (B_DATA (c->key.ydata)) : 0;
+      c->strip_appended[0] = c->strip_appended[1] = 0;
+      c->strip_dropped[0] = c->strip_dropped[1] = 0;
+      c->strip_appends_only = c->valid;
+    }
+}
+
+static void
+strip_note_change (BScatterLineView * scat, BData * data)
+{
+  GHashTableIter iter;
+  gpointer value;
+  int a;
+
+  g_hash_table_iter_init (&iter, scat->cache);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      SeriesCache *c = value;
+      for (a = 0; a < 2; a++)
         {
-          if(!isnan(pos[i].x) & !isnan(pos[i].y))
-            _draw_marker_plus (cr, pos[i], marker_size);
+          if ((a == 0 ? (BData *) c->key.xdata : (BData *) c->key.ydata) != data)
+            continue;
+          const BDataChange *ch = b_data_get_change (data);
+          if (ch != NULL && ch->type == B_DATA_CHANGE_APPEND
+              && ch->generation == c->strip_gen[a] + 1)
+            {
+              c->strip_appended[a] += ch->end - ch->start;
+              c->strip_dropped[a] += ch->n_dropped;
+            }
+          else
+            c->strip_appends_only = FALSE;
+          c->strip_gen[a] = b_data_get_generation (data);
         }
-        break;
-        default:
-        break;
-      }
     }
-  g_free(pos);
-  g_free(buffer);
+}
 
-#if PROFILE
-  gint64 now = g_get_real_time();
-  gint64 then = y_data_get_timestamp(B_DATA(xdata));
-  te = g_timer_elapsed (t, NULL);
-  g_message ("scatter view draw %d points: %f ms", N, te * 1000);
-  g_message ("microseconds: %d",(int) (now-then));
-  g_timer_destroy (t);
-#endif
-  g_clear_object(&xdata);
-  g_clear_object(&ydata);
+static void
+strip_update_node (BScatterLineView * scat)
+{
+  graphene_rect_t bounds;
+  graphene_rect_init (&bounds, 0, 0, scat->strip_width, scat->strip_height);
+  GtkSnapshot *ds = gtk_snapshot_new ();
+  cairo_t *cr = gtk_snapshot_append_cairo (ds, &bounds);
+  cairo_set_source_surface (cr, scat->strip_surface, 0.0, 0.0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  g_clear_pointer (&scat->data_node, gsk_render_node_unref);
+  scat->data_node = gtk_snapshot_free_to_node (ds);
+  scat->data_node_valid = TRUE;
 }
 
 static void
-scatter_view_measure (GtkWidget      *widget,
-         GtkOrientation  orientation,
-         int             for_size,
-         int            *minimum_size,
-         int            *natural_size,
-         int            *minimum_baseline,
-         int            *natural_baseline)
+strip_redraw (BScatterLineView * scat)
 {
-  *minimum_size=1;
-  *natural_size=20;
-  //*minimum_baseline=1;
-  //*natural_baseline=20;
+  GtkWidget *w = GTK_WIDGET (scat);
+  BViewInterval *vix =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *viy =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
+  GHashTableIter iter;
+  gpointer value;
+
+  scat->strip_width = gtk_widget_get_allocated_width (w);
+  scat->strip_height = gtk_widget_get_allocated_height (w);
+  scat->strip_scale = gtk_widget_get_scale_factor (w);
+
+  g_clear_pointer (&scat->strip_surface, cairo_surface_destroy);
+  scat->strip_surface =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                scat->strip_width * scat->strip_scale,
+                                scat->strip_height * scat->strip_scale);
+  cairo_surface_set_device_scale (scat->strip_surface, scat->strip_scale,
+                                  scat->strip_scale);
+  cairo_t *cr = cairo_create (scat->strip_surface);
+  scatter_view_draw_data (w, cr);
+  cairo_destroy (cr);
+
+  b_view_interval_range (vix, &scat->strip_x0, &scat->strip_x1);
+  b_view_interval_range (viy, &scat->strip_y0, &scat->strip_y1);
+  scat->strip_ytype = b_view_interval_get_vi_type (viy);
+  scat->strip_offset = 0.0;
+
+  g_hash_table_iter_init (&iter, scat->cache);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      SeriesCache *c = value;
+      BVector *xdata = c->key.xdata;
+      unsigned int i0, i1, n;
+      c->strip_sorted = FALSE;
+      if (!c->valid)
+        continue;
+      n = b_vector_get_len (c->key.ydata);
+      if (xdata != NULL)
+        n = MIN (n, b_vector_get_len (xdata));
+      c->strip_sorted = xdata == NULL
+        || (n > 0 && index_window (vix, xdata, n, &i0, &i1)
+            && b_vector_get_value (xdata, n - 1) >= b_vector_get_value (xdata, 0));
+    }
+  strip_reset_tracking (scat);
+  strip_update_node (scat);
 }
 
-/* ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** ** */
+/* how many points were appended to the series of @c, or -1 if the raster
+ * can't be updated incrementally */
+static int
+strip_series_new_points (BScatterLineView * scat, SeriesCache * c,
+                         BVector * xdata, BVector * ydata, double x0)
+{
+  unsigned int n, k, i;
+
+  if (!c->valid || !c->strip_appends_only || !c->strip_sorted
+      || c->key.xdata != xdata || c->key.ydata != ydata
+      || c->key.xerr != NULL || c->key.yerr != NULL)
+    return -1;
+
+  n = b_vector_get_len (ydata);
+  k = c->strip_appended[1];
+  if (xdata == NULL)
+    {
+      /* dropping points changes the X of all the others */
+      if (c->strip_dropped[1] > 0)
+        return -1;
+    }
+  else
+    {
+      if (k != c->strip_appended[0] || c->strip_dropped[0] != c->strip_dropped[1]
+          || n != b_vector_get_len (xdata))
+        return -1;
+    }
+  if (k == 0)
+    return 0;
+  if (k >= n)
+    return -1;
+
+  /* the point before the new ones must have been at or left of the old
+     right edge, the new ones must keep X sorted, and the dropped ones must
+     have been out of view */
+  double prev = xdata ? b_vector_get_value (xdata, n - k - 1) : (double) (n - k - 1);
+  if (prev > scat->strip_x1)
+    return -1;
+  if (xdata != NULL)
+    {
+      for (i = n - k; i < n; i++)
+        {
+          double x = b_vector_get_value (xdata, i);
+          if (!(x >= prev))
+            return -1;
+          prev = x;
+        }
+      if (c->strip_dropped[0] > 0 && b_vector_get_value (xdata, 0) > x0)
+        return -1;
+    }
+  return k;
+}
+
+static void
+strip_draw_new_points (BScatterLineView * scat, SeriesCache * c,
+                       BVector * xdata, BVector * ydata, cairo_t * cr, int k)
+{
+  GtkWidget *w = GTK_WIDGET (scat);
+  BViewInterval *vix =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *viy =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
+  const SeriesStyle *st = &c->style;
+  unsigned int n = b_vector_get_len (ydata);
+  int i;
+
+  /* the last old point is included to connect the line */
+  BPoint *pos = g_new (BPoint, k + 1);
+  for (i = 0; i <= k; i++)
+    {
+      unsigned int j = n - k - 1 + i;
+      pos[i].x = b_view_interval_conv (vix, xdata ? b_vector_get_value (xdata, j)
+                                                   : (double) j);
+      pos[i].y = b_view_interval_conv (viy, b_vector_get_value (ydata, j));
+    }
+  _view_conv_bulk (w, pos, pos, k + 1);
+  for (i = 0; i <= k; i++)
+    pos[i].x += scat->strip_offset;
+
+  if (st->draw_line)
+    {
+      cairo_path_t path;
+      line_path_build (&path, pos, k + 1);
+      stroke_line_path (cr, st, &path);
+      g_free (path.data);
+    }
+  if (st->marker != B_MARKER_NONE)
+    {
+      marker_sprites_ensure (c);
+      marker_layer_blit (cairo_get_target (cr), 0, pos + 1, k, c->sprites,
+                         c->sprite_half, scat->strip_scale);
+    }
+  g_free (pos);
+}
 
+/* bring the raster up to date, returning FALSE if it has to be redrawn */
 static gboolean
-scatter_view_draw (GtkWidget * w, cairo_t * cr)
+strip_update (BScatterLineView * scat)
 {
-  BScatterLineView *scat = B_SCATTER_LINE_VIEW (w);
+  GtkWidget *w = GTK_WIDGET (scat);
+  BViewInterval *vix =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_X);
+  BViewInterval *viy =
+    b_element_view_cartesian_get_view_interval (B_ELEMENT_VIEW_CARTESIAN (w),
+                                                B_AXIS_TYPE_Y);
+  double x0, x1, y0, y1;
+  gboolean new_points = FALSE;
+  GList *l;
+
+  if (scat->strip_surface == NULL || !scat->data_node_valid
+      || scat->strip_width != gtk_widget_get_allocated_width (w)
+      || scat->strip_height != gtk_widget_get_allocated_height (w)
+      || scat->strip_scale != gtk_widget_get_scale_factor (w))
+    return FALSE;
 
-  struct draw_struct *s = g_malloc (sizeof (struct draw_struct));
-  s->scat = scat;
-  s->cr = cr;
+  b_view_interval_range (vix, &x0, &x1);
+  b_view_interval_range (viy, &y0, &y1);
+  double span = scat->strip_x1 - scat->strip_x0;
+  if (b_view_interval_get_vi_type (vix) != VIEW_NORMAL
+      || b_view_interval_get_vi_type (viy) != scat->strip_ytype
+      || y0 != scat->strip_y0 || y1 != scat->strip_y1
+      || fabs ((x1 - x0) - span) > 1e-9 * fabs (span))
+    return FALSE;
 
-  g_list_foreach (scat->series, series_draw, s);
+  /* device pixels the content moves left */
+  int device_width = scat->strip_width * scat->strip_scale;
+  double dx = (x0 - scat->strip_x0) / span * device_width;
+  if (dx < 0 || dx >= device_width)
+    return FALSE;
+  int shift = (int) floor (dx + 0.5);
 
-  g_free (s);
+  int *counts = g_new0 (int, g_list_length (scat->series));
+  int i = 0;
+  for (l = scat->series; l != NULL; l = l->next, i++)
+    {
+      BScatterSeries *series = B_SCATTER_SERIES (l->data);
+      BVector *xdata, *ydata;
+      if (!b_scatter_series_get_show (series))
+        continue;
+      g_object_get (series, "x-data", &xdata, "y-data", &ydata, NULL);
+      if (ydata != NULL)
+        {
+          SeriesCache *c = g_hash_table_lookup (scat->cache, series);
+          counts[i] = c ? strip_series_new_points (scat, c, xdata, ydata, x0) : -1;
+        }
+      g_clear_object (&xdata);
+      g_clear_object (&ydata);
+      if (counts[i] < 0)
+        {
+          g_free (counts);
+          return FALSE;
+        }
+      new_points |= counts[i] > 0;
+    }
+
+  if (!new_points && shift == 0)
+    {
+      scat->strip_offset = (x0 - scat->strip_x0) / span * scat->strip_width;
+      g_free (counts);
+      return TRUE;
+    }
+
+  cairo_surface_t *next =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32, device_width,
+                                scat->strip_height * scat->strip_scale);
+  cairo_surface_set_device_scale (next, scat->strip_scale, scat->strip_scale);
+  cairo_t *cr = cairo_create (next);
+  cairo_set_source_surface (cr, scat->strip_surface,
+                            -(double) shift / scat->strip_scale, 0.0);
+  cairo_paint (cr);
+  cairo_surface_destroy (scat->strip_surface);
+  scat->strip_surface = next;
+
+  scat->strip_x0 += shift * span / device_width;
+  scat->strip_x1 = scat->strip_x0 + span;
+  scat->strip_offset = (x0 - scat->strip_x0) / span * scat->strip_width;
+
+  i = 0;
+  for (l = scat->series; l != NULL; l = l->next, i++)
+    {
+      BScatterSeries *series = B_SCATTER_SERIES (l->data);
+      BVector *xdata, *ydata;
+      if (counts[i] <= 0)
+        continue;
+      g_object_get (series, "x-data", &xdata, "y-data", &ydata, NULL);
+      strip_draw_new_points (scat, g_hash_table_lookup (scat->cache, series),
+                             xdata, ydata, cr, counts[i]);
+      g_clear_object (&xdata);
+      g_clear_object (&ydata);
+    }
+  cairo_destroy (cr);
+  g_free (counts);
+
+  strip_reset_tracking (scat);
+  strip_update_node (scat);
+  return TRUE;
+}
+
+static void
+scatter_view_draw_overlay (GtkWidget * w, cairo_t * cr)
+{
+  BScatterLineView *scat = B_SCATTER_LINE_VIEW (w);
 
   /* draw cursors */
   if(scat->show_cursors && !isnan(scat->v_cursor))
@@ -1044,18 +2820,65 @@ scatter_view_draw (GtkWidget * w, cairo_t * cr)
 
       cairo_fill (cr);
     }
-
-  return TRUE;
 }
 
 static void
 b_scatter_view_snapshot (GtkWidget   *w,
                       GtkSnapshot *s)
 {
+  BScatterLineView *scat = B_SCATTER_LINE_VIEW (w);
   graphene_rect_t bounds;
   if (gtk_widget_compute_bounds(w,w,&bounds)) {
+    if (scat->strip_chart) {
+      if (!strip_update (scat))
+        strip_redraw (scat);
+    }
+    else if (scat->threaded) {
+      /* keep showing the last frame until the new one is done */
+      if (!data_layer_is_current (scat)
+          && (scat->frame == NULL || !scat->frame_valid
+              || !series_caches_current (scat))
+          && bounds.size.width >= 1 && bounds.size.height >= 1) {
+        progressive_stop (scat);
+        /* with progressive rendering the preview is shown meanwhile, or is
+           the final image if nothing was left out */
+        if (!scat->progressive || data_layer_draw_coarse (scat, &bounds))
+          raster_frame_start (scat);
+        else {
+          g_clear_pointer (&scat->frame, raster_frame_drop);
+          scat->data_node_valid = TRUE;
+        }
+      }
+    }
+    else if (scat->progressive) {
+      if (!data_layer_is_current (scat)) {
+        progressive_stop (scat);
+        if (data_layer_draw_coarse (scat, &bounds))
+          progressive_start (scat);
+        scat->data_node_valid = TRUE;
+      }
+    }
+    else if (!data_layer_is_current (scat)) {
+      progressive_stop (scat);
+      GtkSnapshot *ds = gtk_snapshot_new ();
+      cairo_t *cr = gtk_snapshot_append_cairo (ds, &bounds);
+      scatter_view_draw_data (w, cr);
+      cairo_destroy (cr);
+      g_clear_pointer (&scat->data_node, gsk_render_node_unref);
+      scat->data_node = gtk_snapshot_free_to_node (ds);
+      scat->data_node_valid = TRUE;
+    }
+    if (scat->data_node != NULL) {
+      gtk_snapshot_save (s);
+      if (scat->strip_chart)
+        gtk_snapshot_translate (s, &GRAPHENE_POINT_INIT (-scat->strip_offset, 0));
+      gtk_snapshot_append_node (s, scat->data_node);
+      gtk_snapshot_restore (s);
+    }
+
     cairo_t *cr = gtk_snapshot_append_cairo (s, &bounds);
-    scatter_view_draw(w, cr);
+    scatter_view_draw_overlay (w, cr);
+    cairo_destroy (cr);
   }
 }
 
@@ -1066,6 +2889,8 @@ on_data_changed (BData * data, gpointer user_data)
 {
   BElementView *mev = (BElementView *) user_data;
   g_return_if_fail (mev!=NULL);
+  if (B_SCATTER_LINE_VIEW (mev)->strip_chart)
+    strip_note_change (B_SCATTER_LINE_VIEW (mev), data);
   b_element_view_changed (mev);
 }
 
@@ -1077,6 +2902,14 @@ on_series_notify (GObject    *gobject,
                gpointer    user_data)
 {
   BElementView *v = (BElementView *) user_data;
+  SeriesCache *c = g_hash_table_lookup (B_SCATTER_LINE_VIEW (v)->cache, gobject);
+  if (c != NULL)
+    {
+      c->style_valid = FALSE;
+      c->valid = FALSE;
+      c->raster_valid = FALSE;
+    }
+  data_layer_invalidate (B_SCATTER_LINE_VIEW (v));
   if(!strcmp("x-data",pspec->name) || !strcmp("y-data",pspec->name) || !strcmp("x-err",pspec->name) || !strcmp("y-err",pspec->name)) {
     BVector *data;
     g_object_get(gobject,pspec->name,&data,NULL);
@@ -1101,12 +2934,15 @@ void
 b_scatter_line_view_add_series (BScatterLineView * v, BScatterSeries * s)
 {
   v->series = g_list_append (v->series, g_object_ref_sink(s));
+  data_layer_invalidate (v);
 
   g_signal_connect(s,"notify",G_CALLBACK(on_series_notify),v);
 
   /* connect changed signals */
   BVector *xdata, *ydata;
-  g_object_get (s, "x-data", &xdata, "y-data", &ydata, NULL);
+  BData *xerr, *yerr;
+  g_object_get (s, "x-data", &xdata, "y-data", &ydata,
+                   "x-err", &xerr, "y-err", &yerr, NULL);
 
   /* TODO: connect to a "subdata changed" signal on series so that:
      - if x is set after series is added, we can connect to signals
@@ -1123,8 +2959,20 @@ b_scatter_line_view_add_series (BScatterLineView * v, BScatterSeries * s)
       g_signal_connect_after (ydata, "changed", G_CALLBACK (on_data_changed),
 			      v);
     }
+  if (xerr != NULL)
+    {
+      g_signal_connect_after (xerr, "changed", G_CALLBACK (on_data_changed),
+			      v);
+    }
+  if (yerr != NULL)
+    {
+      g_signal_connect_after (yerr, "changed", G_CALLBACK (on_data_changed),
+			      v);
+    }
   g_clear_object(&xdata);
   g_clear_object(&ydata);
+  g_clear_object(&xerr);
+  g_clear_object(&yerr);
 
   BElementViewCartesian *cart = (BElementViewCartesian *) v;
   BViewInterval *vix =
@@ -1150,11 +2998,13 @@ b_scatter_line_view_set_property (GObject * object,
 
   switch (property_id)
     {
+    /* cursors are drawn over the retained data layer, so they only need
+       a redraw, not a new preferred range */
     case PROP_V_CURSOR_POS:
       {
         self->v_cursor = g_value_get_double (value);
         if(self->show_cursors) {
-          b_element_view_changed(B_ELEMENT_VIEW(self));
+          gtk_widget_queue_draw (GTK_WIDGET (self));
         }
       }
       break;
@@ -1162,14 +3012,14 @@ b_scatter_line_view_set_property (GObject * object,
       {
         self->h_cursor = g_value_get_double (value);
         if(self->show_cursors) {
-          b_element_view_changed(B_ELEMENT_VIEW(self));
+          gtk_widget_queue_draw (GTK_WIDGET (self));
         }
       }
       break;
     case PROP_SHOW_CURSORS:
       {
         self->show_cursors = g_value_get_boolean (value);
-        b_element_view_changed(B_ELEMENT_VIEW(self));
+        gtk_widget_queue_draw (GTK_WIDGET (self));
       }
       break;
     case PROP_CURSOR_COLOR:
@@ -1177,7 +3027,7 @@ b_scatter_line_view_set_property (GObject * object,
         GdkRGBA *c = g_value_get_pointer (value);
         self->cursor_color = *c;
         if(self->show_cursors) {
-          b_element_view_changed(B_ELEMENT_VIEW(self));
+          gtk_widget_queue_draw (GTK_WIDGET (self));
         }
       }
       break;
@@ -1185,10 +3035,42 @@ b_scatter_line_view_set_property (GObject * object,
       {
         self->cursor_width = g_value_get_double (value);
         if(self->show_cursors) {
-          b_element_view_changed(B_ELEMENT_VIEW(self));
+          gtk_widget_queue_draw (GTK_WIDGET (self));
         }
       }
       break;
+    case PROP_AUTOSCALE_VISIBLE_X:
+      {
+        self->autoscale_visible_x = g_value_get_boolean (value);
+        b_element_view_changed(B_ELEMENT_VIEW(self));
+      }
+      break;
+    case PROP_THREADED:
+      {
+        self->threaded = g_value_get_boolean (value);
+        g_clear_pointer (&self->frame, raster_frame_drop);
+        data_layer_invalidate (self);
+        gtk_widget_queue_draw (GTK_WIDGET (self));
+      }
+      break;
+    case PROP_PROGRESSIVE:
+      {
+        self->progressive = g_value_get_boolean (value);
+        data_layer_invalidate (self);
+        gtk_widget_queue_draw (GTK_WIDGET (self));
+      }
+      break;
+    case PROP_STRIP_CHART:
+      {
+        self->strip_chart = g_value_get_boolean (value);
+        g_clear_pointer (&self->frame, raster_frame_drop);
+        progressive_stop (self);
+        g_clear_pointer (&self->strip_surface, cairo_surface_destroy);
+        self->strip_offset = 0.0;
+        data_layer_invalidate (self);
+        gtk_widget_queue_draw (GTK_WIDGET (self));
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1230,6 +3112,26 @@ b_scatter_line_view_get_property (GObject * object,
         g_value_set_double (value, self->cursor_width);
       }
       break;
+    case PROP_AUTOSCALE_VISIBLE_X:
+      {
+        g_value_set_boolean (value, self->autoscale_visible_x);
+      }
+      break;
+    case PROP_THREADED:
+      {
+        g_value_set_boolean (value, self->threaded);
+      }
+      break;
+    case PROP_PROGRESSIVE:
+      {
+        g_value_set_boolean (value, self->progressive);
+      }
+      break;
+    case PROP_STRIP_CHART:
+      {
+        g_value_set_boolean (value, self->strip_chart);
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -1301,6 +3203,42 @@ b_scatter_line_view_class_init (BScatterLineViewClass * klass)
 							G_PARAM_CONSTRUCT |
 							G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_AUTOSCALE_VISIBLE_X,
+				   g_param_spec_boolean ("autoscale-visible-x",
+							 "Autoscale to visible X",
+							 "Whether Y autoscaling only uses points in the visible X range",
+               FALSE,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT |
+							G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_THREADED,
+				   g_param_spec_boolean ("threaded",
+							 "Threaded rendering",
+							 "Whether series are rasterized in worker threads, keeping the previous frame on screen until the new one is ready",
+               FALSE,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT |
+							G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PROGRESSIVE,
+				   g_param_spec_boolean ("progressive",
+							 "Progressive rendering",
+							 "Whether large series are first drawn from a subset of their points and refined during idle time",
+               FALSE,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT |
+							G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_STRIP_CHART,
+				   g_param_spec_boolean ("strip-chart",
+							 "Strip chart",
+							 "Whether appended points are drawn into the scrolled previous frame instead of redrawing all series. Takes precedence over threaded and progressive rendering",
+               FALSE,
+							G_PARAM_READWRITE |
+							G_PARAM_CONSTRUCT |
+							G_PARAM_STATIC_STRINGS));
+
   widget_class->snapshot = b_scatter_view_snapshot;
   widget_class->measure = scatter_view_measure;
 
@@ -1313,6 +3251,8 @@ static void
 b_scatter_line_view_init (BScatterLineView * obj)
 {
   obj->cursor_color.alpha = 1.0;
+  obj->cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                      series_cache_free);
 
   g_object_set (obj, "valign", GTK_ALIGN_FILL, "halign",
 		GTK_ALIGN_FILL, NULL);
@@ -1382,6 +3322,8 @@ void b_scatter_line_view_remove_series(BScatterLineView *v, const gchar *label)
 {
   GList *found = g_list_find_custom(v->series,g_strdup(label),find_func);
   if(found != NULL) {
+    g_hash_table_remove(v->cache,found->data);
+    data_layer_invalidate (v);
     g_object_unref(found->data);
     v->series = g_list_remove(v->series,found);
   }
@@ -58,7 +58,8 @@ enum
   SCATTER_SERIES_MARKER_COLOR,
   SCATTER_SERIES_MARKER_SIZE,
   SCATTER_SERIES_LABEL,
-  SCATTER_SERIES_TOOLTIP
+  SCATTER_SERIES_TOOLTIP,
+  SCATTER_SERIES_DECIMATION
 };
 
 struct _BScatterSeries
@@ -74,6 +75,8 @@ struct _BScatterSeries
   BMarker marker;
   gchar *label, *tooltip;
   BDashing dashing;
+  BDecimation decimation;
+  double decimation_ratio;
 };
 
 G_DEFINE_TYPE (BScatterSeries, b_scatter_series, G_TYPE_INITIALLY_UNOWNED);
@@ -238,6 +241,11 @@ b_scatter_series_set_property (GObject * object,
         self->tooltip = g_value_dup_string (value);
         break;
       }
+    case SCATTER_SERIES_DECIMATION:
+      {
+        self->decimation = g_value_get_enum (value);
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -324,6 +332,11 @@ b_scatter_series_get_property (GObject * object,
         g_value_set_string (value, self->tooltip);
       }
       break;
+    case SCATTER_SERIES_DECIMATION:
+      {
+        g_value_set_enum (value, self->decimation);
+      }
+      break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -448,6 +461,14 @@ b_scatter_series_class_init (BScatterSeriesClass * klass)
                            1.0, 100.0,
                            DEFAULT_MARKER_SIZE,
                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, SCATTER_SERIES_DECIMATION,
+      g_param_spec_enum ("decimation",
+                         "Decimation",
+                         "Whether to reduce the line to the extreme points in each pixel column",
+                         B_TYPE_DECIMATION,
+                         B_DECIMATION_AUTO,
+                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -455,6 +476,7 @@ b_scatter_series_init (BScatterSeries * obj)
 {
   obj->line_color.alpha = 1.0;
   obj->marker_color.alpha = 1.0;
+  obj->decimation_ratio = 1.0;
 }
 
 /**
@@ -511,6 +533,28 @@ gboolean b_scatter_series_get_show(BScatterSeries *ss)
   return ss->show;
 }
 
+/**
+ * b_scatter_series_get_decimation_ratio:
+ * @ss: a #BScatterSeries
+ *
+ * Get the ratio of the number of points in the series to the number of
+ * vertices used for its line the last time it was drawn. This is 1.0 if the
+ * line was not decimated.
+ *
+ * Returns: the decimation ratio
+ **/
+double b_scatter_series_get_decimation_ratio(BScatterSeries *ss)
+{
+  g_return_val_if_fail(B_IS_SCATTER_SERIES(ss),1.0);
+  return ss->decimation_ratio;
+}
+
+void _b_scatter_series_set_decimation_ratio(BScatterSeries *ss, double ratio)
+{
+  g_return_if_fail(B_IS_SCATTER_SERIES(ss));
+  ss->decimation_ratio = ratio;
+}
+
 cairo_surface_t *_b_scatter_series_create_legend_image(BScatterSeries *series)
 {
   const int width = 30;
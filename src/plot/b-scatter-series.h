@@ -78,6 +78,23 @@ typedef enum {
   B_DASHING_DOT_DASH
 } BDashing;
 
+/**
+ * BDecimation:
+ * @B_DECIMATION_AUTO: decimate when the X data is monotonic and there are
+ * many more points than pixel columns
+ * @B_DECIMATION_ON: always decimate the line
+ * @B_DECIMATION_OFF: never decimate the line
+ *
+ * Enum values used to specify whether the line in a scatter plot is reduced
+ * to the first, last, minimum and maximum point in each pixel column before
+ * it is drawn.
+ */
+typedef enum {
+  B_DECIMATION_AUTO,
+  B_DECIMATION_ON,
+  B_DECIMATION_OFF
+} BDecimation;
+
 G_DECLARE_FINAL_TYPE(BScatterSeries,b_scatter_series,B,SCATTER_SERIES,GInitiallyUnowned)
 
 #define B_TYPE_SCATTER_SERIES (b_scatter_series_get_type())
@@ -89,60 +106,93 @@ void b_scatter_series_set_line_color_from_string (BScatterSeries *ss, gchar * co
 void b_scatter_series_set_marker_color_from_string (BScatterSeries *ss, gchar * colorstring);
 
 gboolean b_scatter_series_get_show(BScatterSeries *ss);
+double b_scatter_series_get_decimation_ratio(BScatterSeries *ss);
+void _b_scatter_series_set_decimation_ratio(BScatterSeries *ss, double ratio);
 cairo_surface_t *_b_scatter_series_create_legend_image(BScatterSeries *ss);
 
 BScatterSeries * b_scatter_series_new();
 
 void _b_dashing_set(BDashing d, double line_width, cairo_t *cr);
 
+/* the paths of the markers, without filling or stroking them */
+
 static inline void
-_draw_marker_circle (cairo_t * cr, BPoint pos, double size, gboolean fill)
+_path_marker_circle (cairo_t * cr, BPoint pos, double size)
 {
+  cairo_new_sub_path (cr);
   cairo_arc (cr, pos.x, pos.y, size / 2, 0, 2 * G_PI);
-  fill ? cairo_fill (cr) : cairo_stroke(cr);
 }
 
 static inline void
-_draw_marker_square (cairo_t * cr, BPoint pos, double size, gboolean fill)
+_path_marker_square (cairo_t * cr, BPoint pos, double size)
 {
   cairo_move_to (cr, pos.x - size / 2, pos.y - size / 2);
   cairo_line_to (cr, pos.x - size / 2, pos.y + size / 2);
   cairo_line_to (cr, pos.x + size / 2, pos.y + size / 2);
   cairo_line_to (cr, pos.x + size / 2, pos.y - size / 2);
   cairo_line_to (cr, pos.x - size / 2, pos.y - size / 2);
-  fill ? cairo_fill (cr) : cairo_stroke(cr);
 }
 
 static inline void
-_draw_marker_diamond (cairo_t * cr, BPoint pos, double size, gboolean fill)
+_path_marker_diamond (cairo_t * cr, BPoint pos, double size)
 {
   cairo_move_to (cr, pos.x - M_SQRT1_2 * size, pos.y);
   cairo_line_to (cr, pos.x, pos.y + M_SQRT1_2 * size);
   cairo_line_to (cr, pos.x + M_SQRT1_2 * size, pos.y);
   cairo_line_to (cr, pos.x, pos.y - M_SQRT1_2 * size);
   cairo_line_to (cr, pos.x - M_SQRT1_2 * size, pos.y);
-  fill ? cairo_fill (cr) : cairo_stroke(cr);
 }
 
 static inline void
-_draw_marker_x (cairo_t * cr, BPoint pos, double size)
+_path_marker_x (cairo_t * cr, BPoint pos, double size)
 {
   cairo_move_to (cr, pos.x - size / 2, pos.y - size / 2);
   cairo_line_to (cr, pos.x + size / 2, pos.y + size / 2);
-  cairo_stroke (cr);
   cairo_move_to (cr, pos.x + size / 2, pos.y - size / 2);
   cairo_line_to (cr, pos.x - size / 2, pos.y + size / 2);
-  cairo_stroke (cr);
 }
 
 static inline void
-_draw_marker_plus (cairo_t * cr, BPoint pos, double size)
+_path_marker_plus (cairo_t * cr, BPoint pos, double size)
 {
   cairo_move_to (cr, pos.x - size / 2, pos.y);
   cairo_line_to (cr, pos.x + size / 2, pos.y);
-  cairo_stroke (cr);
   cairo_move_to (cr, pos.x, pos.y - size / 2);
   cairo_line_to (cr, pos.x, pos.y + size / 2);
+}
+
+static inline void
+_draw_marker_circle (cairo_t * cr, BPoint pos, double size, gboolean fill)
+{
+  _path_marker_circle (cr, pos, size);
+  fill ? cairo_fill (cr) : cairo_stroke(cr);
+}
+
+static inline void
+_draw_marker_square (cairo_t * cr, BPoint pos, double size, gboolean fill)
+{
+  _path_marker_square (cr, pos, size);
+  fill ? cairo_fill (cr) : cairo_stroke(cr);
+}
+
+static inline void
+_draw_marker_diamond (cairo_t * cr, BPoint pos, double size, gboolean fill)
+{
+  _path_marker_diamond (cr, pos, size);
+  fill ? cairo_fill (cr) : cairo_stroke(cr);
+}
+
+static inline void
+_draw_marker_x (cairo_t * cr, BPoint pos, double size)
+{
+  _path_marker_x (cr, pos, size);
+  cairo_stroke (cr);
+}
+
+static inline void
+_draw_marker_plus (cairo_t * cr, BPoint pos, double size)
+{
+  _path_marker_plus (cr, pos, size);
   cairo_stroke (cr);
 }
 
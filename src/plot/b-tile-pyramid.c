@@ -0,0 +1,522 @@
+/*
+ * b-tile-pyramid.c :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "b-tile-pyramid.h"
+#include <math.h>
+#include <string.h>
+
+/* A matrix too large to colorize as a whole is drawn as square tiles of
+ * B_TILE_SIZE elements, taken from a pyramid of levels: level 0 is the
+ * matrix, and each element of level L is the mean of a 2x2 block of level
+ * L-1, ignoring NaN. Only the tiles in view are made, at the level where an
+ * element is about one pixel on the screen.
+ *
+ * A tile of level L > 0 keeps its reduced values, so that recoloring doesn't
+ * read the matrix again. The levels below it are reduced a row at a time
+ * while the tile is made, in the pool threads, and are not kept, except
+ * that tiles of those levels that are already made are read instead. Level 0
+ * tiles are colorized straight from the matrix. Tiles are kept in a most
+ * recently used list, and the least recently used ones are dropped at the
+ * end of a frame when the values and textures take more than the maximum
+ * memory. Only the tiles in view are exempt. */
+
+typedef struct
+{
+  gint64 key;
+  guint level, tx, ty;
+  guint width, height;          /* in elements of the level */
+  float *values;                /* reduced values, for level > 0 */
+  GdkTexture *texture;
+  guchar *pixels;               /* colors waiting to become the texture */
+  guint color_stamp;
+  guint frame;                  /* last frame the tile was used in */
+  GList link;
+} Tile;
+
+struct _BTilePyramid
+{
+  BMatrixRows rows;
+  gboolean have_source;
+  BViewInterval *viz;
+  guint32 lut[B_COLORIZE_LUT_SIZE];
+  guint color_stamp;
+  GHashTable *tiles;
+  GQueue lru;                   /* most recently used first */
+  gsize memory, max_memory;
+  guint frame;
+};
+
+static gint64
+tile_key (guint level, guint tx, guint ty)
+{
+  return ((gint64) level << 48) | ((gint64) ty << 24) | tx;
+}
+
+static gsize
+tile_stride (Tile * t)
+{
+  return (3 * t->width + 3) & ~(gsize) 3;
+}
+
+static gsize
+tile_memory (Tile * t)
+{
+  gsize n = (gsize) t->width * t->height;
+  return (t->values ? n * sizeof (float) : 0)
+    + (t->texture ? tile_stride (t) * t->height : 0);
+}
+
+static void
+tile_free (gpointer data)
+{
+  Tile *t = data;
+
+  g_free (t->values);
+  g_clear_object (&t->texture);
+  g_free (t->pixels);
+  g_free (t);
+}
+
+static void
+level_size (BTilePyramid * p, guint level, guint * cols, guint * rows)
+{
+  *cols = (p->rows.ncol + (1u << level) - 1) >> level;
+  *rows = (p->rows.nrow + (1u << level) - 1) >> level;
+}
+
+/* the links of the list are in the tiles, which the table frees */
+static void
+drop_tiles (BTilePyramid * p)
+{
+  g_queue_init (&p->lru);
+  g_hash_table_remove_all (p->tiles);
+  p->memory = 0;
+}
+
+/* Create a pyramid whose tiles may use up to @max_memory bytes, except
+ * while they are in view. */
+BTilePyramid *
+_b_tile_pyramid_new (gsize max_memory)
+{
+  BTilePyramid *p = g_new0 (BTilePyramid, 1);
+
+  p->tiles = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL,
+                                    tile_free);
+  g_queue_init (&p->lru);
+  p->max_memory = max_memory;
+
+  return p;
+}
+
+void
+_b_tile_pyramid_free (BTilePyramid * p)
+{
+  drop_tiles (p);
+  g_hash_table_unref (p->tiles);
+  g_clear_object (&p->viz);
+  g_free (p);
+}
+
+void
+_b_tile_pyramid_set_max_memory (BTilePyramid * p, gsize max_memory)
+{
+  p->max_memory = max_memory;
+}
+
+/* The memory used by the values and textures of the tiles. */
+gsize
+_b_tile_pyramid_get_memory (BTilePyramid * p)
+{
+  return p->memory;
+}
+
+/* Use @rows as level 0, dropping all tiles. */
+void
+_b_tile_pyramid_set_source (BTilePyramid * p, const BMatrixRows * rows)
+{
+  drop_tiles (p);
+  p->rows = *rows;
+  p->have_source = TRUE;
+}
+
+/* Colorize values converted by @viz with @lut from now on. Tiles are
+ * recolored the next time they are in view. */
+void
+_b_tile_pyramid_set_colors (BTilePyramid * p, BViewInterval * viz,
+                            const guint32 * lut)
+{
+  g_set_object (&p->viz, viz);
+  memcpy (p->lut, lut, sizeof (p->lut));
+  p->color_stamp++;
+}
+
+/* The level at which an element covers at most @elements_per_pixel
+ * elements of the matrix in each direction. */
+guint
+_b_tile_pyramid_choose_level (BTilePyramid * p, double elements_per_pixel)
+{
+  guint level = 0, top = 0;
+
+  while ((p->rows.ncol - 1) >> top >= B_TILE_SIZE
+         || (p->rows.nrow - 1) >> top >= B_TILE_SIZE)
+    top++;
+
+  while (level < top && elements_per_pixel >= (double) (2u << level))
+    level++;
+
+  return level;
+}
+
+static Tile *
+tile_get (BTilePyramid * p, guint level, guint tx, guint ty)
+{
+  gint64 key = tile_key (level, tx, ty);
+  Tile *t = g_hash_table_lookup (p->tiles, &key);
+
+  if (t == NULL)
+    {
+      guint cols, rows;
+      level_size (p, level, &cols, &rows);
+      t = g_new0 (Tile, 1);
+      t->key = key;
+      t->level = level;
+      t->tx = tx;
+      t->ty = ty;
+      t->width = MIN (B_TILE_SIZE, cols - tx * B_TILE_SIZE);
+      t->height = MIN (B_TILE_SIZE, rows - ty * B_TILE_SIZE);
+      t->link.data = t;
+      g_hash_table_insert (p->tiles, &t->key, t);
+    }
+  else
+    g_queue_unlink (&p->lru, &t->link);
+
+  g_queue_push_head_link (&p->lru, &t->link);
+  t->frame = p->frame;
+
+  return t;
+}
+
+static void
+read_source_row (const BMatrixRows * rows, guint i, guint c0, guint n,
+                 double *out)
+{
+  const guchar *row = _b_matrix_rows_get (rows, i);
+  guint j;
+
+  row += c0 * b_element_type_get_size (rows->type);
+
+  switch (rows->type)
+    {
+    case B_ELEMENT_TYPE_DOUBLE:
+      memcpy (out, row, n * sizeof (double));
+      break;
+    case B_ELEMENT_TYPE_FLOAT:
+      for (j = 0; j < n; j++)
+        out[j] = ((const float *) row)[j];
+      break;
+    case B_ELEMENT_TYPE_INT16:
+      for (j = 0; j < n; j++)
+        out[j] = ((const gint16 *) row)[j];
+      break;
+    case B_ELEMENT_TYPE_UINT16:
+      for (j = 0; j < n; j++)
+        out[j] = ((const guint16 *) row)[j];
+      break;
+    case B_ELEMENT_TYPE_UINT8:
+      for (j = 0; j < n; j++)
+        out[j] = ((const guint8 *) row)[j];
+      break;
+    }
+}
+
+/* Average the @n elements of rows @a and @b, which may be NULL at the
+ * bottom of a level, in 2x2 blocks, ignoring NaN, into (@n+1)/2 elements of
+ * @out. */
+static void
+mean_2x2 (const double *a, const double *b, guint n, double *out)
+{
+  guint c, k;
+
+  for (c = 0; 2 * c < n; c++)
+    {
+      double sum = 0.0;
+      int count = 0;
+      for (k = 2 * c; k < MIN (2 * c + 2, n); k++)
+        {
+          if (!isnan (a[k]))
+            {
+              sum += a[k];
+              count++;
+            }
+          if (b != NULL && !isnan (b[k]))
+            {
+              sum += b[k];
+              count++;
+            }
+        }
+      out[c] = count ? sum / count : NAN;
+    }
+}
+
+static void level_row (BTilePyramid * p, guint level, guint i, guint c0,
+                       guint n, double *out);
+
+/* reduce @n elements of row @i of @level > 0, from column @c0, from the
+   level below */
+static void
+reduce_row (BTilePyramid * p, guint level, guint i, guint c0, guint n,
+            double *out)
+{
+  guint below_cols, below_rows;
+
+  level_size (p, level - 1, &below_cols, &below_rows);
+  guint m = MIN (2 * n, below_cols - 2 * c0);
+  gboolean two_rows = 2 * i + 1 < below_rows;
+  double *a = g_new (double, 2 * m);
+
+  level_row (p, level - 1, 2 * i, 2 * c0, m, a);
+  if (two_rows)
+    level_row (p, level - 1, 2 * i + 1, 2 * c0, m, a + m);
+  mean_2x2 (a, two_rows ? a + m : NULL, m, out);
+
+  g_free (a);
+}
+
+/* Read @n elements of row @i of @level, from column @c0, from the tiles
+ * that have values, or else by reducing the level below. The tiles are only
+ * looked up, so this may run in several pool threads at once, as long as
+ * the tiles of @level and below aren't being made. */
+static void
+level_row (BTilePyramid * p, guint level, guint i, guint c0, guint n,
+           double *out)
+{
+  guint j = 0, k;
+
+  if (level == 0)
+    {
+      read_source_row (&p->rows, i, c0, n, out);
+      return;
+    }
+
+  while (j < n)
+    {
+      guint c = c0 + j;
+      guint m = MIN (n - j, B_TILE_SIZE - c % B_TILE_SIZE);
+      gint64 key = tile_key (level, c / B_TILE_SIZE, i / B_TILE_SIZE);
+      Tile *t = g_hash_table_lookup (p->tiles, &key);
+      if (t != NULL && t->values != NULL)
+        {
+          const float *v = t->values + (i % B_TILE_SIZE) * t->width
+            + c % B_TILE_SIZE;
+          for (k = 0; k < m; k++)
+            out[j + k] = v[k];
+        }
+      else
+        reduce_row (p, level, i, c, m, out + j);
+      j += m;
+    }
+}
+
+/* Read @n elements of row @i of @level of the pyramid, from column @c0,
+ * which must be inside the level. For tests. */
+void
+_b_tile_pyramid_get_row (BTilePyramid * p, guint level, guint i, guint c0,
+                         guint n, double *out)
+{
+  level_row (p, level, i, c0, n, out);
+}
+
+/* The tiles to colorize are split into rows, so that the threads share the
+ * work even when only one tile is in view, which is the case for a whole
+ * matrix at the top level. */
+typedef struct
+{
+  BTilePyramid *p;
+  Tile **tiles;
+  gboolean *reduce;             /* whether the values are to be computed */
+  guint *first_row;             /* of each tile, in the rows of all of them */
+  guint n_tiles;
+} Colorize;
+
+/* colorize the rows from @start to @end, after reducing their values if
+   needed; may run in a pool thread */
+static void
+colorize_tiles (guint start, guint end, gpointer user_data)
+{
+  Colorize *z = user_data;
+  BTilePyramid *p = z->p;
+  double *data = g_new (double, B_TILE_SIZE);
+  guint k = 0, q;
+
+  while (z->first_row[k + 1] <= start)
+    k++;
+
+  for (q = start; q < end; q++)
+    {
+      while (z->first_row[k + 1] <= q)
+        k++;
+
+      Tile *t = z->tiles[k];
+      guint r = q - z->first_row[k];
+      guint i = t->ty * B_TILE_SIZE + r;
+
+      if (t->level == 0)
+        b_view_interval_conv_bulk_typed (p->viz,
+          (const guchar *) _b_matrix_rows_get (&p->rows, i)
+            + t->tx * B_TILE_SIZE * b_element_type_get_size (p->rows.type),
+          p->rows.type, data, t->width);
+      else
+        {
+          float *v = t->values + r * t->width;
+          guint c;
+          if (z->reduce[k])
+            {
+              reduce_row (p, t->level, i, t->tx * B_TILE_SIZE, t->width,
+                          data);
+              for (c = 0; c < t->width; c++)
+                v[c] = data[c];
+            }
+          b_view_interval_conv_bulk_typed (p->viz, v, B_ELEMENT_TYPE_FLOAT,
+                                           data, t->width);
+        }
+      /* rows are stored last row first */
+      _b_colorize_row (data, t->pixels + (t->height - 1 - r) * tile_stride (t),
+                       t->width, p->lut);
+    }
+
+  g_free (data);
+}
+
+static void
+evict (BTilePyramid * p)
+{
+  GList *l = p->lru.tail;
+
+  /* the tiles of this frame are at the head */
+  while (l != NULL && p->memory > p->max_memory)
+    {
+      Tile *t = l->data;
+      l = l->prev;
+      if (t->frame == p->frame)
+        break;
+      p->memory -= tile_memory (t);
+      g_queue_unlink (&p->lru, &t->link);
+      g_hash_table_remove (p->tiles, &t->key);
+    }
+}
+
+/* Append the tiles of @level that intersect @visible to @s, which may be
+ * NULL to only make them. Coordinates are those of the image of the whole
+ * matrix, one unit per element, with the last row at the top. */
+void
+_b_tile_pyramid_snapshot (BTilePyramid * p, GtkSnapshot * s,
+                          const graphene_rect_t * visible, guint level)
+{
+  guint nrow = p->rows.nrow, ncol = p->rows.ncol;
+  guint tx, ty, k;
+
+  if (!p->have_source || p->viz == NULL || nrow == 0 || ncol == 0)
+    return;
+
+  p->frame++;
+
+  /* visible columns and rows of the matrix */
+  double x0 = MAX (visible->origin.x, 0.0);
+  double x1 = MIN (visible->origin.x + visible->size.width, (double) ncol);
+  double i0 = MAX (nrow - (visible->origin.y + visible->size.height), 0.0);
+  double i1 = MIN (nrow - visible->origin.y, (double) nrow);
+  if (x1 <= x0 || i1 <= i0)
+    return;
+
+  guint c0 = x0, c1 = ceil (x1);
+  guint r0 = i0, r1 = ceil (i1);
+  guint tx0 = (c0 >> level) / B_TILE_SIZE, tx1 = ((c1 - 1) >> level) / B_TILE_SIZE;
+  guint ty0 = (r0 >> level) / B_TILE_SIZE, ty1 = ((r1 - 1) >> level) / B_TILE_SIZE;
+
+  GPtrArray *shown = g_ptr_array_new ();
+  GPtrArray *stale = g_ptr_array_new ();
+
+  for (ty = ty0; ty <= ty1; ty++)
+    for (tx = tx0; tx <= tx1; tx++)
+      {
+        Tile *t = tile_get (p, level, tx, ty);
+        g_ptr_array_add (shown, t);
+        if (t->texture == NULL || t->color_stamp != p->color_stamp)
+          g_ptr_array_add (stale, t);
+      }
+
+  /* the buffers are made here, so the threads only fill them */
+  Colorize z = { p, (Tile **) stale->pdata, g_new (gboolean, stale->len),
+                 g_new (guint, stale->len + 1), stale->len };
+  z.first_row[0] = 0;
+  for (k = 0; k < stale->len; k++)
+    {
+      Tile *t = z.tiles[k];
+      p->memory -= tile_memory (t);
+      z.reduce[k] = t->level > 0 && t->values == NULL;
+      if (z.reduce[k])
+        t->values = g_new (float, (gsize) t->width * t->height);
+      t->pixels = g_malloc (tile_stride (t) * t->height);
+      z.first_row[k + 1] = z.first_row[k] + t->height;
+    }
+
+  if (stale->len > 0)
+    _b_parallel_rows (z.first_row[stale->len], colorize_tiles, &z);
+
+  for (k = 0; k < stale->len; k++)
+    {
+      Tile *t = z.tiles[k];
+      GBytes *bytes = g_bytes_new_take (t->pixels, tile_stride (t) * t->height);
+      g_clear_object (&t->texture);
+      t->texture = gdk_memory_texture_new (t->width, t->height,
+                                           GDK_MEMORY_R8G8B8, bytes,
+                                           tile_stride (t));
+      t->pixels = NULL;
+      t->color_stamp = p->color_stamp;
+      p->memory += tile_memory (t);
+      g_bytes_unref (bytes);
+    }
+  g_free (z.reduce);
+  g_free (z.first_row);
+
+  if (s != NULL)
+    {
+      /* the last tiles of a level may reach past the matrix */
+      gtk_snapshot_push_clip (s, &GRAPHENE_RECT_INIT (0, 0, ncol, nrow));
+      for (k = 0; k < shown->len; k++)
+        {
+          Tile *t = g_ptr_array_index (shown, k);
+          double scale = 1u << level;
+          graphene_rect_t r =
+            GRAPHENE_RECT_INIT (t->tx * B_TILE_SIZE * scale,
+                                nrow - (t->ty * B_TILE_SIZE + t->height) * scale,
+                                t->width * scale, t->height * scale);
+          gtk_snapshot_append_scaled_texture (s, t->texture,
+                                              GSK_SCALING_FILTER_NEAREST, &r);
+        }
+      gtk_snapshot_pop (s);
+    }
+
+  g_ptr_array_unref (shown);
+  g_ptr_array_unref (stale);
+
+  evict (p);
+}
@@ -0,0 +1,65 @@
+/*
+ * b-tile-pyramid.h :
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#pragma once
+
+/* Not installed: the tiled image used by the density view for large
+ * matrices. */
+
+#include <gtk/gtk.h>
+#include "plot/b-colorize.h"
+#include "plot/b-view-interval.h"
+
+G_BEGIN_DECLS
+
+#define B_TILE_SIZE 256
+
+typedef struct _BTilePyramid BTilePyramid;
+
+G_GNUC_INTERNAL
+BTilePyramid *_b_tile_pyramid_new (gsize max_memory);
+G_GNUC_INTERNAL
+void _b_tile_pyramid_free (BTilePyramid *p);
+
+G_GNUC_INTERNAL
+void _b_tile_pyramid_set_max_memory (BTilePyramid *p, gsize max_memory);
+
+G_GNUC_INTERNAL
+gsize _b_tile_pyramid_get_memory (BTilePyramid *p);
+
+G_GNUC_INTERNAL
+void _b_tile_pyramid_set_source (BTilePyramid *p, const BMatrixRows *rows);
+G_GNUC_INTERNAL
+void _b_tile_pyramid_set_colors (BTilePyramid *p, BViewInterval *viz,
+                                 const guint32 *lut);
+
+G_GNUC_INTERNAL
+guint _b_tile_pyramid_choose_level (BTilePyramid *p,
+                                    double elements_per_pixel);
+G_GNUC_INTERNAL
+void _b_tile_pyramid_snapshot (BTilePyramid *p, GtkSnapshot *s,
+                               const graphene_rect_t *visible, guint level);
+
+G_GNUC_INTERNAL
+void _b_tile_pyramid_get_row (BTilePyramid *p, guint level, guint i,
+                              guint c0, guint n, double *out);
+
+G_END_DECLS
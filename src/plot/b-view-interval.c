@@ -478,6 +478,73 @@ b_view_interval_conv_bulk (BViewInterval * v,
     }
 }
 
+#define CONV_TYPED(T, expr)			\
+  {						\
+    const T *in = in_data;			\
+    for (i = 0; i < N; ++i)			\
+      {						\
+	x = in[i];				\
+	out_data[i] = (expr);			\
+      }						\
+  }						\
+  break
+
+#define CONV_ALL_TYPES(expr)				\
+  switch (type)						\
+    {							\
+    case B_ELEMENT_TYPE_DOUBLE: CONV_TYPED (double, expr);	\
+    case B_ELEMENT_TYPE_FLOAT: CONV_TYPED (float, expr);	\
+    case B_ELEMENT_TYPE_INT16: CONV_TYPED (gint16, expr);	\
+    case B_ELEMENT_TYPE_UINT16: CONV_TYPED (guint16, expr);	\
+    case B_ELEMENT_TYPE_UINT8: CONV_TYPED (guint8, expr);	\
+    }
+
+/**
+ * b_view_interval_conv_bulk_typed :
+ * @v: #BViewInterval
+ * @in_data: values to convert, of type @type
+ * @type: the element type of @in_data
+ * @out_data: output array of values
+ * @N: length of arrays
+ *
+ * Like b_view_interval_conv_bulk(), but reads the values in their native
+ * storage type, as returned by b_vector_get_native_values() or
+ * b_matrix_get_native_values(), so they do not need to be converted to double
+ * precision first.
+ **/
+void
+b_view_interval_conv_bulk_typed (BViewInterval * v,
+				 gconstpointer in_data, BElementType type,
+				 double *out_data, gsize N)
+{
+  double t0, x, scale;
+  gsize i;
+
+  g_return_if_fail (B_IS_VIEW_INTERVAL (v));
+  g_return_if_fail (out_data != NULL);
+  g_return_if_fail (N == 0 || in_data != NULL);
+
+  if (N == 0)
+    return;
+
+  t0 = v->t0;
+
+  if (v->type == VIEW_NORMAL)
+    {
+      scale = 1.0 / (v->t1 - t0);
+      CONV_ALL_TYPES ((x - t0) * scale);
+    }
+  else if (v->type == VIEW_LOG)
+    {
+      scale = 1.0 / log (v->t1 / t0);
+      CONV_ALL_TYPES (log (x / t0) * scale);
+    }
+  else
+    {
+      g_assert_not_reached ();
+    }
+}
+
 /**
  * b_view_interval_unconv_bulk :
  * @v: #BViewInterval
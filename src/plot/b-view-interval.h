@@ -27,6 +27,7 @@
 #pragma once
 
 #include <gtk/gtk.h>
+#include "data/b-data-class.h"
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,9 @@ int b_view_interval_get_vi_type(BViewInterval *v);
 
 void b_view_interval_conv_bulk (BViewInterval * v,
 				    const double *in_data, double *out_data, gsize N);
+void b_view_interval_conv_bulk_typed (BViewInterval * v,
+				     gconstpointer in_data, BElementType type,
+				     double *out_data, gsize N);
 void b_view_interval_unconv_bulk (BViewInterval * v,
 				      const double *in_data, double *out_data, gsize N);
 
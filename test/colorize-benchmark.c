@@ -0,0 +1,156 @@
+/*
+ * colorize-benchmark.c
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/* Compares the throughput of the density view's colorization kernel, on one
+ * thread and split across rows, with the per-pixel loop it used to run. The
+ * input is already normalized to [0,1], as it is after the view interval
+ * conversion. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "plot/b-colorize.h"
+
+#define ROWS 4096
+#define COLS 4096
+#define REPEATS 10
+
+typedef struct
+{
+  const double *t;
+  guchar *pixels;
+  const guint32 *lut;
+} Frame;
+
+static void
+branchy_rows (const double *t, guchar *pixels, const guint32 *lut32)
+{
+  const guchar *lut = (const guchar *) lut32;
+  int i, j;
+
+  for (i = 0; i < ROWS; i++)
+    for (j = 0; j < COLS; j++)
+      {
+        guchar *p = &pixels[3 * ((gsize) i * COLS + j)];
+        double ds = t[(gsize) i * COLS + j];
+        if (isnan (ds))
+          {
+            p[0] = p[1] = p[2] = 0;
+          }
+        else if (ds <= 0.0)
+          {
+            p[0] = lut[0];
+            p[1] = lut[1];
+            p[2] = lut[2];
+          }
+        else if (ds >= 1.0)
+          {
+            p[0] = lut[4 * 255];
+            p[1] = lut[4 * 255 + 1];
+            p[2] = lut[4 * 255 + 2];
+          }
+        else
+          {
+            int ss = (int) (ds * 255);
+            p[0] = lut[4 * ss];
+            p[1] = lut[4 * ss + 1];
+            p[2] = lut[4 * ss + 2];
+          }
+      }
+}
+
+static void
+kernel_rows (guint start, guint end, gpointer user_data)
+{
+  Frame *f = user_data;
+  guint i;
+
+  for (i = start; i < end; i++)
+    _b_colorize_row (&f->t[(gsize) i * COLS], &f->pixels[3 * (gsize) i * COLS],
+                     COLS, f->lut);
+}
+
+static void
+report (const char *name, gint64 usec)
+{
+  double sec = usec / 1e6 / REPEATS;
+  printf ("%-24s %8.3f ms  %8.1f MP/s\n", name, sec * 1e3,
+          (double) ROWS * COLS / sec / 1e6);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gsize n = (gsize) ROWS * COLS;
+  double *t = g_new (double, n);
+  guchar *ref = g_new (guchar, 3 * n);
+  guchar *out = g_new (guchar, 3 * n);
+  guint32 lut[B_COLORIZE_LUT_SIZE];
+  Frame f = { t, out, lut };
+  gsize i;
+  int k;
+
+  for (i = 0; i < 256; i++)
+    lut[i] = GUINT32_TO_BE (((guint32) i << 24) | ((255 - i) << 16)
+                            | ((i * 7 % 256) << 8) | 255);
+  lut[B_COLORIZE_NAN] = 0;
+
+  /* a little outside [0,1] on both ends, with some NaN */
+  for (i = 0; i < n; i++)
+    t[i] = 0.5 + 0.6 * sin (0.0001 * i) + 0.01 * rand () / RAND_MAX;
+  for (i = 0; i < n; i += 997)
+    t[i] = NAN;
+
+  gint64 start = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    branchy_rows (t, ref, lut);
+  report ("per-pixel branches", g_get_monotonic_time () - start);
+
+  start = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    kernel_rows (0, ROWS, &f);
+  report ("kernel, 1 thread", g_get_monotonic_time () - start);
+
+  if (memcmp (ref, out, 3 * n) != 0)
+    {
+      fprintf (stderr, "kernel results differ\n");
+      return 1;
+    }
+
+  memset (out, 0, 3 * n);
+  start = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    _b_parallel_rows (ROWS, kernel_rows, &f);
+  report ("kernel, parallel rows", g_get_monotonic_time () - start);
+
+  if (memcmp (ref, out, 3 * n) != 0)
+    {
+      fprintf (stderr, "parallel results differ\n");
+      return 1;
+    }
+
+  g_free (t);
+  g_free (ref);
+  g_free (out);
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * minmax-benchmark.c
+ *
+ * Copyright (C) 2016 Scott O. Johnson (scojo202@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/* Compares the throughput of b_vector_get_minmax() and b_matrix_get_minmax()
+ * with the element-by-element loop they used to run. */
+
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "data/b-data-simple.h"
+
+#define ROWS 3162
+#define COLS 3162
+#define REPEATS 20
+
+static void
+scalar_minmax (const double *v, unsigned int i, double *min, double *max)
+{
+  double minimum = DBL_MAX, maximum = -DBL_MAX;
+
+  while (i-- > 0)
+    {
+      if (!isfinite (v[i]))
+        continue;
+      if (minimum > v[i])
+        minimum = v[i];
+      if (maximum < v[i])
+        maximum = v[i];
+    }
+  *min = minimum;
+  *max = maximum;
+}
+
+static void
+report (const char *name, gint64 usec, gsize n)
+{
+  double sec = usec / 1e6 / REPEATS;
+  printf ("%-24s %8.3f ms  %8.1f Melem/s  %6.2f GB/s\n", name, sec * 1e3,
+          n / sec / 1e6, n * sizeof (double) / sec / 1e9);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gsize n = (gsize) ROWS * COLS;
+  double *vals = g_new (double, n);
+  double mn = 0, mx = 0, mn2 = 0, mx2 = 0;
+  gsize i;
+  int k;
+
+  for (i = 0; i < n; i++)
+    vals[i] = sin (0.001 * i) * 100.0 + (double) rand () / RAND_MAX;
+  /* sprinkle in some values that must be skipped */
+  for (i = 0; i < n; i += 1001)
+    vals[i] = (i % 2) ? NAN : INFINITY;
+
+  BValMatrix *mat = B_VAL_MATRIX (b_val_matrix_new (vals, ROWS, COLS, NULL));
+  g_object_ref_sink (mat);
+
+  gint64 t = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    scalar_minmax (vals, n, &mn, &mx);
+  report ("scalar loop", g_get_monotonic_time () - t, n);
+
+  t = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    {
+      b_data_emit_changed (B_DATA (mat));
+      b_matrix_get_minmax (B_MATRIX (mat), &mn2, &mx2);
+    }
+  report ("b_matrix_get_minmax", g_get_monotonic_time () - t, n);
+
+  if (mn != mn2 || mx != mx2)
+    {
+      fprintf (stderr, "results differ: %g %g, %g %g\n", mn, mx, mn2, mx2);
+      return 1;
+    }
+
+  BValVector *vec = B_VAL_VECTOR (b_val_vector_new (vals, n, NULL));
+  g_object_ref_sink (vec);
+
+  t = g_get_monotonic_time ();
+  for (k = 0; k < REPEATS; k++)
+    {
+      b_data_emit_changed (B_DATA (vec));
+      b_vector_get_minmax (B_VECTOR (vec), &mn2, &mx2);
+    }
+  report ("b_vector_get_minmax", g_get_monotonic_time () - t, n);
+
+  g_object_unref (vec);
+  g_object_unref (mat);
+  g_free (vals);
+
+  return 0;
+}
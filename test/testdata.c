@@ -1,8 +1,12 @@
 #include <math.h>
+#include <float.h>
+#include <glib/gstdio.h>
 #include "data/b-data-simple.h"
 #include "data/b-ring.h"
 #include "data/b-linear-range.h"
 #include "data/b-struct.h"
+#include "data/b-data-typed.h"
+#include "data/b-data-file.h"
 
 #define N 1000
 
@@ -122,6 +126,406 @@ test_simple_vector_copy(void)
   g_free(vals0);
 }
 
+static void
+test_simple_vector_minmax(void)
+{
+  double vals[40];
+  int i, n;
+  for(n=1;n<=40;n++) {
+    double rmn = DBL_MAX, rmx = -DBL_MAX;
+    for(i=0;i<n;i++) {
+      if(i%5==3)
+        vals[i]=NAN;
+      else if(i%7==6)
+        vals[i]=(i%2) ? INFINITY : -INFINITY;
+      else {
+        vals[i]=(double)((i*17)%23)-11.0;
+        rmn = MIN(rmn,vals[i]);
+        rmx = MAX(rmx,vals[i]);
+      }
+    }
+    g_autoptr(BValVector) vv = B_VAL_VECTOR(b_val_vector_new_copy (vals,n));
+    double mn, mx;
+    b_vector_get_minmax(B_VECTOR(vv),&mn,&mx);
+    g_assert_cmpfloat(mn, ==, rmn);
+    g_assert_cmpfloat(mx, ==, rmx);
+  }
+
+  for(i=0;i<40;i++) {
+    vals[i]=NAN;
+  }
+  g_autoptr(BValVector) vv = B_VAL_VECTOR(b_val_vector_new_copy (vals,40));
+  g_assert_false(b_data_has_value(B_DATA(vv)));
+}
+
+static void
+test_typed_vector(void)
+{
+  gint16 vals[5] = {3, -7, 12, 0, -1};
+  g_autoptr(BTypedVector) tv = B_TYPED_VECTOR(b_typed_vector_new_copy (vals,B_ELEMENT_TYPE_INT16,5));
+  g_assert_cmpuint(b_vector_get_len(B_VECTOR(tv)), ==, 5);
+  g_assert_cmpfloat(b_vector_get_value(B_VECTOR(tv),1), ==, -7.0);
+
+  BElementType type;
+  const gint16 *native = b_vector_get_native_values(B_VECTOR(tv),&type);
+  g_assert_cmpint(type, ==, B_ELEMENT_TYPE_INT16);
+  g_assert_cmpint(native[2], ==, 12);
+
+  double mn, mx;
+  b_vector_get_minmax(B_VECTOR(tv),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, -7.0);
+  g_assert_cmpfloat(mx, ==, 12.0);
+
+  const double *v = b_vector_get_values(B_VECTOR(tv));
+  int i;
+  for(i=0;i<5;i++) {
+    g_assert_cmpfloat(v[i], ==, vals[i]);
+  }
+
+  gint16 *data = b_typed_vector_get_data(tv,NULL);
+  data[0] = 100;
+  b_data_emit_changed(B_DATA(tv));
+  b_vector_get_minmax(B_VECTOR(tv),&mn,&mx);
+  g_assert_cmpfloat(mx, ==, 100.0);
+  g_assert_cmpfloat(b_vector_get_values(B_VECTOR(tv))[0], ==, 100.0);
+
+  float fvals[4] = {1.5f, NAN, -2.5f, INFINITY};
+  b_typed_vector_replace_data(tv,g_memdup2(fvals,sizeof(fvals)),B_ELEMENT_TYPE_FLOAT,4,g_free);
+  g_assert_cmpuint(b_vector_get_len(B_VECTOR(tv)), ==, 4);
+  b_vector_get_minmax(B_VECTOR(tv),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, -2.5);
+  g_assert_cmpfloat(mx, ==, 1.5);
+
+  g_autoptr(BData) d = b_data_dup(B_DATA(tv));
+  g_assert_true(B_IS_TYPED_VECTOR(d));
+  g_assert_cmpfloat(b_vector_get_value(B_VECTOR(d),2), ==, -2.5);
+
+  /* plain vectors report their doubles as native values */
+  g_autoptr(BData) vv = b_val_vector_new_copy (v,5);
+  g_assert_true(b_vector_get_native_values(B_VECTOR(vv),&type) == (gconstpointer) b_vector_get_values(B_VECTOR(vv)));
+  g_assert_cmpint(type, ==, B_ELEMENT_TYPE_DOUBLE);
+}
+
+static void
+test_typed_matrix(void)
+{
+  g_autoptr(BTypedMatrix) tm = B_TYPED_MATRIX(b_typed_matrix_new_alloc (B_ELEMENT_TYPE_UINT16,3,4));
+  BMatrixSize size = b_matrix_get_size(B_MATRIX(tm));
+  g_assert_cmpuint(size.rows, ==, 3);
+  g_assert_cmpuint(size.columns, ==, 4);
+
+  BElementType type;
+  guint16 *data = b_typed_matrix_get_data(tm,&type);
+  g_assert_cmpint(type, ==, B_ELEMENT_TYPE_UINT16);
+  int i;
+  for(i=0;i<12;i++) {
+    data[i] = 1000*i+5;
+  }
+  b_data_emit_changed(B_DATA(tm));
+
+  g_assert_cmpfloat(b_matrix_get_value(B_MATRIX(tm),2,1), ==, 9005.0);
+  double mn, mx;
+  b_matrix_get_minmax(B_MATRIX(tm),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 5.0);
+  g_assert_cmpfloat(mx, ==, 11005.0);
+
+  const double *v = b_matrix_get_values(B_MATRIX(tm));
+  g_assert_cmpfloat(v[11], ==, 11005.0);
+  g_assert_true(b_matrix_get_native_values(B_MATRIX(tm),&type) == (gconstpointer) data);
+
+  guint8 bytes[6] = {0, 255, 7, 8, 9, 10};
+  g_autoptr(BData) m8 = b_typed_matrix_new_copy (bytes,B_ELEMENT_TYPE_UINT8,2,3);
+  b_matrix_get_minmax(B_MATRIX(m8),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 0.0);
+  g_assert_cmpfloat(mx, ==, 255.0);
+  g_assert_cmpfloat(b_matrix_get_value(B_MATRIX(m8),1,2), ==, 10.0);
+}
+
+static char *
+write_npy(const char *descr, const char *shape, gconstpointer data, gsize size, goffset *offset)
+{
+  GString *f = g_string_new_len("\x93NUMPY\x01\x00\x00\x00",10);
+  g_string_append_printf(f,"{'descr': '%s', 'fortran_order': False, 'shape': %s, }",descr,shape);
+  while((f->len+1)%64 != 0)
+    g_string_append_c(f,' ');
+  g_string_append_c(f,'\n');
+  f->str[8] = (f->len-10) & 0xff;
+  f->str[9] = (f->len-10) >> 8;
+  if(offset)
+    *offset = f->len;
+  g_string_append_len(f,data,size);
+
+  char *path = NULL;
+  int fd = g_file_open_tmp("betta-test-XXXXXX.npy",&path,NULL);
+  g_assert_cmpint(fd, >=, 0);
+  g_close(fd,NULL);
+  g_assert_true(g_file_set_contents(path,f->str,f->len,NULL));
+  g_string_free(f,TRUE);
+  return path;
+}
+
+static void
+test_file_mmap(void)
+{
+  double vals[12];
+  int i;
+  for(i=0;i<12;i++) {
+    vals[i]=i*1.5;
+  }
+
+  goffset offset;
+  g_autofree char *path = write_npy("<f8","(3, 4)",vals,sizeof(vals),&offset);
+  GError *err = NULL;
+  g_autoptr(BData) m = b_data_new_from_npy(path,&err);
+  g_assert_no_error(err);
+  g_assert_true(B_IS_VAL_MATRIX(m));
+  g_assert_cmpuint(b_matrix_get_rows(B_MATRIX(m)), ==, 3);
+  g_assert_cmpuint(b_matrix_get_columns(B_MATRIX(m)), ==, 4);
+  g_assert_cmpfloat(b_matrix_get_value(B_MATRIX(m),2,3), ==, 16.5);
+
+  g_autoptr(BData) md = b_data_dup(m);
+  g_clear_object(&m);
+  g_assert_cmpuint(b_matrix_get_rows(B_MATRIX(md)), ==, 3);
+  g_assert_cmpfloat(b_matrix_get_value(B_MATRIX(md),1,0), ==, 6.0);
+
+  /* the same file as raw doubles, skipping the header */
+  g_autoptr(BData) rv = b_val_vector_new_mmap(path,offset,&err);
+  g_assert_no_error(err);
+  g_assert_cmpuint(b_vector_get_len(B_VECTOR(rv)), ==, 12);
+  g_assert_cmpfloat(b_vector_get_values(B_VECTOR(rv))[5], ==, 7.5);
+  g_autoptr(BData) rm = b_val_matrix_new_mmap(path,offset,5,&err);
+  g_assert_no_error(err);
+  g_assert_cmpuint(b_matrix_get_rows(B_MATRIX(rm)), ==, 2);
+  g_assert_null(b_val_vector_new_mmap(path,offset+3,&err));
+  g_assert_error(err,G_FILE_ERROR,G_FILE_ERROR_INVAL);
+  g_clear_error(&err);
+  g_unlink(path);
+  g_free(g_steal_pointer(&path));
+
+  guint16 u[6] = {1, 2, 3, 400, 5, 6};
+  path = write_npy("<u2","(6,)",u,sizeof(u),NULL);
+  g_autoptr(BData) v = b_data_new_from_npy(path,&err);
+  g_assert_no_error(err);
+  g_assert_true(B_IS_TYPED_VECTOR(v));
+  BElementType type;
+  const guint16 *native = b_vector_get_native_values(B_VECTOR(v),&type);
+  g_assert_cmpint(type, ==, B_ELEMENT_TYPE_UINT16);
+  g_assert_cmpint(native[3], ==, 400);
+  double mn, mx;
+  b_vector_get_minmax(B_VECTOR(v),&mn,&mx);
+  g_assert_cmpfloat(mx, ==, 400.0);
+  g_unlink(path);
+  g_free(g_steal_pointer(&path));
+
+  path = write_npy("<u2","(2, 4)",u,sizeof(u),NULL);
+  g_assert_null(b_data_new_from_npy(path,&err));
+  g_assert_error(err,G_FILE_ERROR,G_FILE_ERROR_INVAL);
+  g_clear_error(&err);
+  g_unlink(path);
+  g_free(g_steal_pointer(&path));
+
+  /* more elements than an unsigned int can count */
+  path = write_npy("|u1","(100000, 100000)",u,sizeof(u),NULL);
+  g_assert_null(b_data_new_from_npy(path,&err));
+  g_assert_error(err,G_FILE_ERROR,G_FILE_ERROR_INVAL);
+  g_assert_true(g_str_has_suffix(err->message,"has too many elements"));
+  g_clear_error(&err);
+  g_unlink(path);
+}
+
+static void
+test_vector_range(void)
+{
+  int n = 2000, i, k;
+  double *vals = g_new(double,n);
+  for(i=0;i<n;i++) {
+    vals[i] = sin(i*0.37)*i;
+    if(i%97==5)
+      vals[i] = NAN;
+  }
+  g_autoptr(BValVector) v = B_VAL_VECTOR(b_val_vector_new(vals,n,g_free));
+
+  for(k=0;k<200;k++) {
+    unsigned int s = g_test_rand_int_range(0,n);
+    unsigned int e = g_test_rand_int_range(s,n+1);
+    double rmn = DBL_MAX, rmx = -DBL_MAX, mn, mx;
+    for(i=s;i<e;i++) {
+      if(isfinite(vals[i])) {
+        rmn = MIN(rmn,vals[i]);
+        rmx = MAX(rmx,vals[i]);
+      }
+    }
+    gboolean found = b_vector_get_range_minmax(B_VECTOR(v),s,e,&mn,&mx);
+    g_assert_true(found == (rmn <= rmx));
+    g_assert_cmpfloat(mn, ==, rmn);
+    g_assert_cmpfloat(mx, ==, rmx);
+  }
+
+  /* the index follows changes */
+  vals[1000] = 1e9;
+  b_data_emit_changed(B_DATA(v));
+  double mn, mx;
+  b_vector_get_range_minmax(B_VECTOR(v),0,n,&mn,&mx);
+  g_assert_cmpfloat(mx, ==, 1e9);
+
+  /* a changed range only updates its own blocks: element 600 is changed
+     behind the vector's back, which a rebuild would notice */
+  vals[600] = 1e10;
+  vals[1500] = -1e9;
+  b_data_emit_changed_range(B_DATA(v),1500,1501);
+  b_vector_get_range_minmax(B_VECTOR(v),256,n,&mn,&mx);
+  g_assert_cmpfloat(mn, ==, -1e9);
+  g_assert_cmpfloat(mx, ==, 1e9);
+  b_data_emit_changed(B_DATA(v));
+  b_vector_get_range_minmax(B_VECTOR(v),256,n,&mn,&mx);
+  g_assert_cmpfloat(mx, ==, 1e10);
+
+  /* and so do appends to a ring, as old elements scroll out */
+  double *ref = g_new(double,20000);
+  for(i=0;i<20000;i++)
+    ref[i] = (i%89==7) ? NAN : cos(i*0.11)*(i%500);
+  BRingVector *r = B_RING_VECTOR(b_ring_vector_new(1000, 0, FALSE));
+  b_ring_vector_append_array(r,ref,300);
+  b_vector_get_range_minmax(B_VECTOR(r),0,300,&mn,&mx);
+  unsigned int m = 300;
+  while(m<20000) {
+    unsigned int len = g_test_rand_int_range(1,400);
+    len = MIN(len,20000-m);
+    b_ring_vector_append_array(r,ref+m,len);
+    m += len;
+    unsigned int rn = MIN(m,1000);
+    for(k=0;k<20;k++) {
+      unsigned int s = g_test_rand_int_range(0,rn);
+      unsigned int e = g_test_rand_int_range(s,rn+1);
+      double rmn = DBL_MAX, rmx = -DBL_MAX;
+      for(i=s;i<e;i++) {
+        double x = ref[m-rn+i];
+        if(isfinite(x)) {
+          rmn = MIN(rmn,x);
+          rmx = MAX(rmx,x);
+        }
+      }
+      b_vector_get_range_minmax(B_VECTOR(r),s,e,&mn,&mx);
+      g_assert_cmpfloat(mn, ==, rmn);
+      g_assert_cmpfloat(mx, ==, rmx);
+    }
+  }
+  g_object_unref(r);
+  g_free(ref);
+
+  unsigned int s, e;
+  g_assert_false(b_vector_find_range(B_VECTOR(v),0.0,10.0,&s,&e));
+
+  guint16 x[1000];
+  for(i=0;i<1000;i++) {
+    x[i] = 2*i;
+  }
+  g_autoptr(BData) tx = b_typed_vector_new_copy(x,B_ELEMENT_TYPE_UINT16,1000);
+  g_assert_true(b_vector_find_range(B_VECTOR(tx),9.0,400.0,&s,&e));
+  g_assert_cmpuint(s, ==, 5);
+  g_assert_cmpuint(e, ==, 201);
+  b_vector_get_range_minmax(B_VECTOR(tx),s,e,&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 10.0);
+  g_assert_cmpfloat(mx, ==, 400.0);
+
+  double d[5] = {5.0, 4.0, 4.0, 2.0, 1.0};
+  g_autoptr(BData) dv = b_val_vector_new_copy(d,5);
+  g_assert_true(b_vector_find_range(B_VECTOR(dv),4.0,1.5,&s,&e));
+  g_assert_cmpuint(s, ==, 1);
+  g_assert_cmpuint(e, ==, 4);
+}
+
+static void
+test_vector_search(void)
+{
+  double a[6] = {1.0, 2.0, 2.0, 4.0, 8.0, 16.0};
+  g_autoptr(BData) v = b_val_vector_new_copy(a,6);
+  g_assert_false(b_vector_is_varying_uniformly(B_VECTOR(v)));
+  g_assert_true(b_vector_is_sorted(B_VECTOR(v)));
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),5.0,B_SEARCH_NEAREST), ==, 3);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),7.0,B_SEARCH_NEAREST), ==, 4);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),5.0,B_SEARCH_LOWER), ==, 3);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),5.0,B_SEARCH_UPPER), ==, 4);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),2.0,B_SEARCH_LOWER), ==, 2);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),2.0,B_SEARCH_UPPER), ==, 1);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),0.5,B_SEARCH_LOWER), ==, -1);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),0.5,B_SEARCH_NEAREST), ==, 0);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),20.0,B_SEARCH_UPPER), ==, -1);
+  g_assert_cmpint(b_vector_search(B_VECTOR(v),20.0,B_SEARCH_NEAREST), ==, 5);
+
+  gint16 d[4] = {30, 20, 10, -10};
+  g_autoptr(BData) dv = b_typed_vector_new_copy(d,B_ELEMENT_TYPE_INT16,4);
+  g_assert_true(b_vector_is_varying_uniformly(B_VECTOR(dv)));
+  g_assert_true(b_vector_is_sorted(B_VECTOR(dv)));
+  g_assert_cmpint(b_vector_search(B_VECTOR(dv),12.0,B_SEARCH_NEAREST), ==, 2);
+  g_assert_cmpint(b_vector_search(B_VECTOR(dv),12.0,B_SEARCH_LOWER), ==, 2);
+  g_assert_cmpint(b_vector_search(B_VECTOR(dv),12.0,B_SEARCH_UPPER), ==, 1);
+  g_assert_cmpint(b_vector_search(B_VECTOR(dv),-20.0,B_SEARCH_LOWER), ==, -1);
+
+  double u[3] = {1.0, 3.0, 2.0};
+  g_autoptr(BData) uv = b_val_vector_new_copy(u,3);
+  g_assert_false(b_vector_is_varying_uniformly(B_VECTOR(uv)));
+  g_assert_false(b_vector_is_sorted(B_VECTOR(uv)));
+  g_assert_cmpint(b_vector_search(B_VECTOR(uv),2.0,B_SEARCH_NEAREST), ==, -1);
+
+  /* the order is updated as a ring vector grows */
+  BRingVector *r = B_RING_VECTOR(b_ring_vector_new(5, 0, FALSE));
+  int i;
+  for(i=0;i<8;i++) {
+    b_ring_vector_append(r,(double)i);
+    g_assert_true(b_vector_is_varying_uniformly(B_VECTOR(r)));
+  }
+  g_assert_cmpint(b_vector_search(B_VECTOR(r),5.4,B_SEARCH_NEAREST), ==, 2);
+  b_ring_vector_append(r,0.0);
+  g_assert_false(b_vector_is_varying_uniformly(B_VECTOR(r)));
+  for(i=0;i<4;i++)
+    b_ring_vector_append(r,(double)(i+1));
+  g_assert_true(b_vector_is_varying_uniformly(B_VECTOR(r)));
+  b_ring_vector_append(r,NAN);
+  g_assert_false(b_vector_is_sorted(B_VECTOR(r)));
+  g_assert_cmpint(b_vector_search(B_VECTOR(r),2.0,B_SEARCH_NEAREST), ==, -1);
+  g_object_unref(r);
+
+  /* ties, as in timestamps shared by a block of appends, scroll out */
+  double t[9] = {0.0, 0.0, 1.0, 2.0, 3.0, 3.0, 4.0, 5.0, 6.0};
+  gboolean strict[9] = {FALSE, FALSE, FALSE, FALSE, TRUE, FALSE, FALSE, FALSE, TRUE};
+  r = B_RING_VECTOR(b_ring_vector_new(4, 0, FALSE));
+  for(i=0;i<9;i++) {
+    b_ring_vector_append(r,t[i]);
+    g_assert_true(b_vector_is_sorted(B_VECTOR(r)));
+    if(i>=3)
+      g_assert_cmpint(b_vector_is_varying_uniformly(B_VECTOR(r)), ==, strict[i]);
+  }
+  g_object_unref(r);
+
+  /* appends inside an update, and to timestamps, keep the order cached: the
+     first elements are changed behind the vectors' backs, which a rescan
+     would notice */
+  r = B_RING_VECTOR(b_ring_vector_new(8, 0, TRUE));
+  BRingVector *ts = b_ring_vector_get_timestamps(r);
+  const double *seg;
+  for(i=0;i<4;i++)
+    b_ring_vector_append(r,(double)i);
+  g_assert_true(b_vector_is_sorted(B_VECTOR(r)));
+  g_assert_true(b_vector_is_sorted(B_VECTOR(ts)));
+  b_ring_vector_get_segments(r,&seg,NULL,NULL,NULL);
+  ((double *)seg)[0] = 100.0;
+  b_ring_vector_get_segments(ts,&seg,NULL,NULL,NULL);
+  ((double *)seg)[0] = DBL_MAX;
+  b_data_begin_update(B_DATA(r));
+  for(i=4;i<6;i++)
+    b_ring_vector_append(r,(double)i);
+  b_data_end_update(B_DATA(r));
+  b_ring_vector_append(r,6.0);
+  g_assert_true(b_vector_is_sorted(B_VECTOR(r)));
+  g_assert_true(b_vector_is_sorted(B_VECTOR(ts)));
+  b_data_emit_changed(B_DATA(r));
+  b_data_emit_changed(B_DATA(ts));
+  g_assert_false(b_vector_is_sorted(B_VECTOR(r)));
+  g_assert_false(b_vector_is_sorted(B_VECTOR(ts)));
+  g_object_unref(r);
+}
+
 static void
 test_ring_vector(void)
 {
@@ -204,6 +608,264 @@ test_ring_vector(void)
     g_assert_cmpfloat(arr[3+i], ==, b_vector_get_value(B_VECTOR(r),i));
   }
 
+  /* wrap around the end of the buffer */
+  b_ring_vector_append(r,arr[9]);
+  const double *first, *second;
+  unsigned int n_first, n_second;
+  g_assert_cmpuint(6, ==, b_ring_vector_get_segments(r,&first,&n_first,&second,&n_second));
+  g_assert_cmpuint(5, ==, n_first);
+  g_assert_cmpuint(1, ==, n_second);
+  g_assert_cmpmem(first,5*sizeof(double),&arr[4],5*sizeof(double));
+  g_assert_cmpfloat(arr[9], ==, second[0]);
+  const double *vals = b_vector_get_values(B_VECTOR(r));
+  g_assert_cmpmem(vals,6*sizeof(double),&arr[4],6*sizeof(double));
+  double mn, mx;
+  b_vector_get_minmax(B_VECTOR(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, arr[4]);
+  g_assert_cmpfloat(mx, ==, arr[9]);
+
+  b_ring_vector_set_max_length(r,4);
+  g_assert_cmpuint(4, ==, b_vector_get_len(B_VECTOR(r)));
+  for(i=0;i<4;i++) {
+    g_assert_cmpfloat(arr[6+i], ==, b_vector_get_value(B_VECTOR(r),i));
+  }
+
+  /* extrema are updated as values are appended, skipping non-finite values */
+  b_ring_vector_append(r,NAN);
+  b_ring_vector_append(r,1.0);
+  b_vector_get_minmax(B_VECTOR(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 1.0);
+  g_assert_cmpfloat(mx, ==, 256.0);
+  b_ring_vector_append(r,0.5);
+  b_ring_vector_append(r,INFINITY);
+  b_vector_get_minmax(B_VECTOR(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 0.5);
+  g_assert_cmpfloat(mx, ==, 1.0);
+  for(i=0;i<100;i++) {
+    b_ring_vector_append(r,(double)((i*7)%13));
+    b_vector_get_minmax(B_VECTOR(r),&mn,&mx);
+    const double *v = b_vector_get_values(B_VECTOR(r));
+    double vmn = DBL_MAX, vmx = -DBL_MAX;
+    int j;
+    for(j=0;j<4;j++) {
+      if(isfinite(v[j])) {
+        vmn = MIN(vmn,v[j]);
+        vmx = MAX(vmx,v[j]);
+      }
+    }
+    g_assert_cmpfloat(mn, ==, vmn);
+    g_assert_cmpfloat(mx, ==, vmx);
+  }
+
+  g_object_unref(r);
+}
+
+static void
+count_changed(BData *d, gpointer user_data)
+{
+  int *count = (int *) user_data;
+  (*count)++;
+}
+
+static void
+test_ring_update(void)
+{
+  BRingVector *r = B_RING_VECTOR(b_ring_vector_new(100, 0, TRUE));
+  BRingVector *ts = b_ring_vector_get_timestamps(r);
+  int nr = 0, nts = 0;
+  g_signal_connect(r,"changed",G_CALLBACK(count_changed),&nr);
+  g_signal_connect(ts,"changed",G_CALLBACK(count_changed),&nts);
+
+  b_ring_vector_append(r,1.0);
+  g_assert_cmpint(1, ==, nr);
+  g_assert_cmpint(1, ==, nts);
+  g_assert_cmpuint(1, ==, b_vector_get_len(B_VECTOR(ts)));
+
+  double arr[50];
+  int i;
+  for(i=0;i<50;i++) {
+    arr[i]=(double)i;
+  }
+  b_ring_vector_append_array(r,arr,50);
+  g_assert_cmpint(2, ==, nr);
+  g_assert_cmpint(2, ==, nts);
+  g_assert_cmpuint(51, ==, b_vector_get_len(B_VECTOR(ts)));
+
+  b_data_begin_update(B_DATA(r));
+  b_data_begin_update(B_DATA(r));
+  for(i=0;i<10;i++) {
+    b_ring_vector_append(r,(double)i);
+  }
+  /* the cache is still kept up to date */
+  g_assert_cmpuint(61, ==, b_vector_get_len(B_VECTOR(r)));
+  g_assert_cmpfloat(9.0, ==, b_vector_get_values(B_VECTOR(r))[60]);
+  b_data_end_update(B_DATA(r));
+  b_ring_vector_append_array(r,arr,50);
+  g_assert_cmpint(2, ==, nr);
+  g_assert_cmpint(2, ==, nts);
+  b_data_end_update(B_DATA(r));
+  g_assert_cmpint(3, ==, nr);
+  g_assert_cmpint(3, ==, nts);
+  g_assert_cmpuint(100, ==, b_vector_get_len(B_VECTOR(r)));
+  g_assert_cmpuint(100, ==, b_vector_get_len(B_VECTOR(ts)));
+
+  /* nothing changed, so nothing is emitted */
+  b_data_begin_update(B_DATA(r));
+  b_data_end_update(B_DATA(r));
+  g_assert_cmpint(3, ==, nr);
+
+  g_object_unref(r);
+}
+
+#define N_PRODUCERS 4
+#define N_PER_PRODUCER 2000
+
+static gpointer
+ingest_thread(gpointer user_data)
+{
+  BRingVector *r = B_RING_VECTOR(user_data);
+  static gint next_id = 0;
+  int id = g_atomic_int_add(&next_id,1);
+  double block[10];
+  int i, j;
+  for(i=0;i<N_PER_PRODUCER;i+=10) {
+    for(j=0;j<10;j++) {
+      block[j] = id*N_PER_PRODUCER + i + j;
+    }
+    while(!b_ring_vector_ingest(r,block,10))
+      g_thread_yield();
+  }
+  return NULL;
+}
+
+static void
+check_change(BData *d, BDataChangeType type, guint start, guint end, guint n_dropped)
+{
+  const BDataChange *c = b_data_get_change(d);
+  g_assert_cmpint(c->type, ==, type);
+  if(type == B_DATA_CHANGE_ALL)
+    return;
+  g_assert_cmpuint(c->start, ==, start);
+  g_assert_cmpuint(c->end, ==, end);
+  g_assert_cmpuint(c->n_dropped, ==, n_dropped);
+}
+
+static void
+test_data_change(void)
+{
+  g_autoptr(BRingVector) r = B_RING_VECTOR(b_ring_vector_new(5, 0, TRUE));
+  BData *d = B_DATA(r);
+  double arr[4] = {1.0, 2.0, 3.0, 4.0};
+  g_assert_cmpuint(b_data_get_generation(d), ==, 0);
+
+  b_ring_vector_append_array(r,arr,3);
+  check_change(d,B_DATA_CHANGE_APPEND,0,3,0);
+  g_assert_cmpuint(b_data_get_generation(d), ==, 1);
+  g_assert_cmpuint(b_data_get_change(d)->generation, ==, 1);
+  check_change(B_DATA(b_ring_vector_get_timestamps(r)),B_DATA_CHANGE_APPEND,0,3,0);
+
+  b_ring_vector_append_array(r,arr,4);
+  check_change(d,B_DATA_CHANGE_APPEND,1,5,2);
+
+  /* appends in an update are merged */
+  b_data_begin_update(d);
+  b_ring_vector_append(r,5.0);
+  b_ring_vector_append(r,6.0);
+  b_data_end_update(d);
+  check_change(d,B_DATA_CHANGE_APPEND,3,5,2);
+  g_assert_cmpuint(b_data_get_generation(d), ==, 3);
+
+  b_ring_vector_set_length(r,2);
+  check_change(d,B_DATA_CHANGE_ALL,0,0,0);
+
+  g_autoptr(BRingMatrix) m = B_RING_MATRIX(b_ring_matrix_new(2, 2, 0, FALSE));
+  b_ring_matrix_append(m,arr,2);
+  check_change(B_DATA(m),B_DATA_CHANGE_APPEND,0,1,0);
+  b_ring_matrix_append(m,arr,2);
+  b_ring_matrix_append(m,arr,2);
+  check_change(B_DATA(m),B_DATA_CHANGE_APPEND,1,2,1);
+
+  g_autoptr(BValVector) v = B_VAL_VECTOR(b_val_vector_new_alloc(10));
+  b_val_vector_replace_array(v,g_new0(double,10),10,g_free);
+  check_change(B_DATA(v),B_DATA_CHANGE_RANGE,0,10,0);
+  b_val_vector_replace_array(v,g_new0(double,4),4,g_free);
+  check_change(B_DATA(v),B_DATA_CHANGE_ALL,0,0,0);
+
+  b_data_begin_update(B_DATA(v));
+  b_data_emit_changed_range(B_DATA(v),2,3);
+  b_data_emit_changed_range(B_DATA(v),1,2);
+  b_data_end_update(B_DATA(v));
+  check_change(B_DATA(v),B_DATA_CHANGE_RANGE,1,3,0);
+
+  b_data_begin_update(B_DATA(v));
+  b_data_emit_changed_range(B_DATA(v),2,3);
+  b_data_emit_changed(B_DATA(v));
+  b_data_end_update(B_DATA(v));
+  check_change(B_DATA(v),B_DATA_CHANGE_ALL,0,0,0);
+  g_assert_cmpuint(b_data_get_generation(B_DATA(v)), ==, 4);
+}
+
+static void
+test_ring_ingest(void)
+{
+  BRingVector *r = B_RING_VECTOR(b_ring_vector_new(N_PRODUCERS*N_PER_PRODUCER, 0, FALSE));
+  int nr = 0;
+  g_signal_connect(r,"changed",G_CALLBACK(count_changed),&nr);
+  b_ring_vector_enable_ingest(r,100);
+
+  double arr[200] = {0.0,};
+  g_assert_false(b_ring_vector_ingest(r,arr,200));
+  g_assert_true(b_ring_vector_ingest(r,arr,128));
+  g_assert_false(b_ring_vector_ingest(r,arr,1));
+  g_assert_cmpuint(128, ==, b_ring_vector_drain(r));
+  g_assert_cmpint(1, ==, nr);
+  g_assert_cmpuint(0, ==, b_ring_vector_drain(r));
+  b_ring_vector_set_length(r,0);
+
+  /* the main loop drains the queue */
+  arr[0] = 5.0;
+  g_assert_true(b_ring_vector_ingest(r,arr,1));
+  while(b_vector_get_len(B_VECTOR(r))==0)
+    g_main_context_iteration(NULL,TRUE);
+  g_assert_cmpfloat(5.0, ==, b_vector_get_value(B_VECTOR(r),0));
+  b_ring_vector_set_length(r,0);
+
+  GThread *threads[N_PRODUCERS];
+  int i;
+  for(i=0;i<N_PRODUCERS;i++) {
+    threads[i] = g_thread_new("producer",ingest_thread,r);
+  }
+  unsigned int total = 0;
+  while(total < N_PRODUCERS*N_PER_PRODUCER) {
+    total += b_ring_vector_drain(r);
+  }
+  for(i=0;i<N_PRODUCERS;i++) {
+    g_thread_join(threads[i]);
+  }
+
+  /* each producer's values arrive complete and in order */
+  int last[N_PRODUCERS] = {-1,-1,-1,-1};
+  const double *v = b_vector_get_values(B_VECTOR(r));
+  g_assert_cmpuint(N_PRODUCERS*N_PER_PRODUCER, ==, b_vector_get_len(B_VECTOR(r)));
+  for(i=0;i<N_PRODUCERS*N_PER_PRODUCER;i++) {
+    int id = (int)v[i]/N_PER_PRODUCER;
+    int k = (int)v[i]%N_PER_PRODUCER;
+    g_assert_cmpint(k, ==, last[id]+1);
+    last[id] = k;
+  }
+
+  BRingMatrix *m = B_RING_MATRIX(b_ring_matrix_new(4,10,0,FALSE));
+  b_ring_matrix_enable_ingest(m,8);
+  double row[4] = {1.0,2.0,3.0,4.0};
+  g_assert_true(b_ring_matrix_ingest(m,row,4));
+  g_assert_true(b_ring_matrix_ingest(m,row,2));
+  g_assert_cmpuint(2, ==, b_ring_matrix_drain(m));
+  g_assert_cmpuint(2, ==, b_matrix_get_rows(B_MATRIX(m)));
+  g_assert_cmpfloat(4.0, ==, b_matrix_get_value(B_MATRIX(m),0,3));
+  g_assert_cmpfloat(2.0, ==, b_matrix_get_value(B_MATRIX(m),1,1));
+  g_assert_cmpfloat(0.0, ==, b_matrix_get_value(B_MATRIX(m),1,2));
+
+  g_object_unref(m);
   g_object_unref(r);
 }
 
@@ -227,6 +889,45 @@ test_ring_matrix(void)
   }
   b_ring_matrix_set_rows(r,5);
   g_assert_cmpuint(5, ==, b_matrix_get_rows(B_MATRIX(r)));
+
+  b_ring_matrix_set_max_rows(r,3);
+  g_assert_cmpuint(3, ==, b_matrix_get_rows(B_MATRIX(r)));
+  for(i=0;i<10;i++) {
+    vals[i]=(double)(10+i);
+  }
+  b_ring_matrix_append(r,vals,10);
+  b_ring_matrix_append(r,vals,5);
+  g_assert_cmpuint(3, ==, b_matrix_get_rows(B_MATRIX(r)));
+  g_assert_cmpfloat(0.0, ==, b_matrix_get_value(B_MATRIX(r),0,0));
+  g_assert_cmpfloat(10.0, ==, b_matrix_get_value(B_MATRIX(r),1,0));
+  g_assert_cmpfloat(14.0, ==, b_matrix_get_value(B_MATRIX(r),2,4));
+  g_assert_cmpfloat(0.0, ==, b_matrix_get_value(B_MATRIX(r),2,5));
+
+  const double *first, *second;
+  unsigned int r_first, r_second;
+  g_assert_cmpuint(3, ==, b_ring_matrix_get_row_segments(r,&first,&r_first,&second,&r_second));
+  g_assert_cmpuint(1, ==, r_first);
+  g_assert_cmpuint(2, ==, r_second);
+  g_assert_true(b_ring_matrix_get_row(r,1)==second);
+  g_assert_cmpmem(b_ring_matrix_get_row(r,1),10*sizeof(double),vals,10*sizeof(double));
+  const double *v = b_matrix_get_values(B_MATRIX(r));
+  g_assert_cmpmem(&v[10],10*sizeof(double),vals,10*sizeof(double));
+  g_assert_cmpfloat(14.0, ==, v[24]);
+
+  double mn, mx;
+  b_matrix_get_minmax(B_MATRIX(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 0.0);
+  g_assert_cmpfloat(mx, ==, 19.0);
+  vals[0] = NAN;
+  b_ring_matrix_append(r,vals,10);
+  b_ring_matrix_append(r,vals,10);
+  b_matrix_get_minmax(B_MATRIX(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 0.0);
+  g_assert_cmpfloat(mx, ==, 19.0);
+  b_ring_matrix_append(r,vals,10);
+  b_matrix_get_minmax(B_MATRIX(r),&mn,&mx);
+  g_assert_cmpfloat(mn, ==, 11.0);
+  g_assert_cmpfloat(mx, ==, 19.0);
   g_object_unref(r);
 }
 
@@ -292,8 +993,17 @@ main (int argc, char *argv[])
   g_test_add_func("/BData/simple/vector_new",test_simple_vector_new);
   g_test_add_func("/BData/simple/vector_alloc",test_simple_vector_alloc);
   g_test_add_func("/BData/simple/vector_copy",test_simple_vector_copy);
+  g_test_add_func("/BData/simple/vector_minmax",test_simple_vector_minmax);
+  g_test_add_func("/BData/simple/vector_range",test_vector_range);
+  g_test_add_func("/BData/simple/vector_search",test_vector_search);
+  g_test_add_func("/BData/typed/vector",test_typed_vector);
+  g_test_add_func("/BData/typed/matrix",test_typed_matrix);
+  g_test_add_func("/BData/file/mmap",test_file_mmap);
   g_test_add_func("/BData/ring/vector",test_ring_vector);
   g_test_add_func("/BData/ring/matrix",test_ring_matrix);
+  g_test_add_func("/BData/ring/update",test_ring_update);
+  g_test_add_func("/BData/ring/ingest",test_ring_ingest);
+  g_test_add_func("/BData/change",test_data_change);
   g_test_add_func("/BData/range",test_range_vectors);
   g_test_add_func("/BData/struct",test_struct);
 
@@ -0,0 +1,170 @@
+#include <math.h>
+#include "data/b-data-simple.h"
+#include "plot/b-tile-pyramid.h"
+
+static void
+assert_same (double a, double b)
+{
+  if (isnan (a))
+    g_assert_true (isnan (b));
+  else
+    g_assert_cmpfloat (a, ==, b);
+}
+
+static BTilePyramid *
+pyramid_new (BMatrix * m, gsize max_memory)
+{
+  BTilePyramid *p = _b_tile_pyramid_new (max_memory);
+  BMatrixRows rows;
+  g_assert_true (_b_matrix_rows_init (&rows, m));
+  _b_tile_pyramid_set_source (p, &rows);
+  return p;
+}
+
+/* the next level of a matrix, reduced the obvious way */
+static double *
+reduce (const double *v, guint rows, guint cols, guint * rrows, guint * rcols)
+{
+  guint i, j, a, b;
+
+  *rrows = (rows + 1) / 2;
+  *rcols = (cols + 1) / 2;
+  double *r = g_new (double, *rrows * *rcols);
+  for (i = 0; i < *rrows; i++)
+    for (j = 0; j < *rcols; j++)
+      {
+        double sum = 0.0;
+        int count = 0;
+        for (b = 2 * j; b < MIN (2 * j + 2, cols); b++)
+          for (a = 2 * i; a < MIN (2 * i + 2, rows); a++)
+            if (!isnan (v[a * cols + b]))
+              {
+                sum += v[a * cols + b];
+                count++;
+              }
+        r[i * *rcols + j] = count ? sum / count : NAN;
+      }
+  return r;
+}
+
+static void
+test_tiles_mean (void)
+{
+  double small[] = { 1, 2, 3,
+                     NAN, 6, NAN,
+                     7, 8, 9 };
+  g_autoptr(BValMatrix) sm = B_VAL_MATRIX (b_val_matrix_new_copy (small, 3, 3));
+  BTilePyramid *p = pyramid_new (B_MATRIX (sm), 1 << 20);
+  double row[2];
+
+  /* NaN is left out of the mean, and a block at the edge of the matrix
+     averages the elements it has */
+  _b_tile_pyramid_get_row (p, 1, 0, 0, 2, row);
+  g_assert_cmpfloat (row[0], ==, 3.0);
+  g_assert_cmpfloat (row[1], ==, 3.0);
+  _b_tile_pyramid_get_row (p, 1, 1, 0, 2, row);
+  g_assert_cmpfloat (row[0], ==, 7.5);
+  g_assert_cmpfloat (row[1], ==, 9.0);
+  _b_tile_pyramid_free (p);
+
+  /* several tiles, with odd sizes and a block that is all NaN */
+  guint rows = 700, cols = 900, i, j, level;
+  g_autoptr(BValMatrix) m = B_VAL_MATRIX (b_val_matrix_new_alloc (rows, cols));
+  double *v = b_val_matrix_get_array (m);
+  for (i = 0; i < rows; i++)
+    for (j = 0; j < cols; j++)
+      v[i * cols + j] = sin (0.01 * i) + cos (0.013 * j);
+  v[3 * cols + 5] = NAN;
+  for (i = 296; i < 304; i++)
+    for (j = 512; j < 520; j++)
+      v[i * cols + j] = NAN;
+
+  p = pyramid_new (B_MATRIX (m), 1 << 20);
+  double *ref = g_memdup2 (v, sizeof (double) * rows * cols);
+  double *out = g_new (double, cols);
+  for (level = 1; level < 4; level++)
+    {
+      double *next = reduce (ref, rows, cols, &rows, &cols);
+      g_free (ref);
+      ref = next;
+      for (i = 0; i < rows; i++)
+        {
+          _b_tile_pyramid_get_row (p, level, i, 0, cols, out);
+          for (j = 0; j < cols; j++)
+            assert_same (out[j], ref[i * cols + j]);
+        }
+      /* a part of a row that starts inside a tile */
+      _b_tile_pyramid_get_row (p, level, rows / 2, 3, cols - 3, out);
+      for (j = 3; j < cols; j++)
+        assert_same (out[j - 3], ref[rows / 2 * cols + j]);
+    }
+  g_assert_true (isnan (ref[(296 / 8) * cols + 512 / 8]));
+
+  g_free (ref);
+  g_free (out);
+  _b_tile_pyramid_free (p);
+}
+
+static void
+test_tiles_evict (void)
+{
+  guint n = 4 * B_TILE_SIZE, i, j;
+  g_autoptr(BValMatrix) m = B_VAL_MATRIX (b_val_matrix_new_alloc (n, n));
+  double *v = b_val_matrix_get_array (m);
+  for (i = 0; i < n; i++)
+    for (j = 0; j < n; j++)
+      v[i * n + j] = i + j;
+
+  g_autoptr(BViewInterval) viz = b_view_interval_new ();
+  b_view_interval_set (viz, 0, 2 * n);
+  guint32 lut[B_COLORIZE_LUT_SIZE] = { 0 };
+
+  gsize texture = (gsize) 3 * B_TILE_SIZE * B_TILE_SIZE;
+  gsize values = (gsize) sizeof (float) * B_TILE_SIZE * B_TILE_SIZE;
+  BTilePyramid *p = pyramid_new (B_MATRIX (m), 2 * texture);
+  _b_tile_pyramid_set_colors (p, viz, lut);
+
+  /* the tiles in view are kept, whatever the limit */
+  graphene_rect_t all = GRAPHENE_RECT_INIT (0, 0, n, n);
+  _b_tile_pyramid_snapshot (p, NULL, &all, 0);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, 16 * texture);
+
+  /* and the least recently used others are dropped down to it */
+  graphene_rect_t corner = GRAPHENE_RECT_INIT (0, 0, 10, 10);
+  _b_tile_pyramid_snapshot (p, NULL, &corner, 0);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, 2 * texture);
+
+  /* the level in view keeps its values, but not the levels below it */
+  _b_tile_pyramid_snapshot (p, NULL, &all, 2);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, texture + values);
+  double row[B_TILE_SIZE];
+  _b_tile_pyramid_get_row (p, 2, 0, 0, B_TILE_SIZE, row);
+  for (j = 0; j < B_TILE_SIZE; j++)
+    g_assert_cmpfloat (row[j], ==, 4 * j + 3);
+
+  /* recoloring doesn't reduce again */
+  _b_tile_pyramid_set_colors (p, viz, lut);
+  _b_tile_pyramid_snapshot (p, NULL, &all, 2);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, texture + values);
+
+  /* a new source drops all tiles */
+  BMatrixRows rows;
+  g_assert_true (_b_matrix_rows_init (&rows, B_MATRIX (m)));
+  _b_tile_pyramid_set_source (p, &rows);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, 0);
+  _b_tile_pyramid_snapshot (p, NULL, &corner, 0);
+  g_assert_cmpuint (_b_tile_pyramid_get_memory (p), ==, texture);
+
+  _b_tile_pyramid_free (p);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/BTilePyramid/mean", test_tiles_mean);
+  g_test_add_func ("/BTilePyramid/evict", test_tiles_evict);
+
+  return g_test_run ();
+}